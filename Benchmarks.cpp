@@ -0,0 +1,249 @@
+﻿#include "Benchmarks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "CircuitScriptLexer.h"
+#include "CircuitScriptParallelParser.h"
+#include "CircuitScriptParser.h"
+#include "CompactGraph.h"
+#include "FlatHashMap.h"
+#include "Graph.h"
+#include "ParallelStrongComponents.h"
+#include "StrongComponents.h"
+#include "WorkStealingThreadPool.h"
+
+namespace
+{
+	template <typename Fn>
+	double Milliseconds(Fn&& fn)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// The pair hash the path table had before, (a, b) and (b, a), and every two pairs with the same XOR, share a bucket
+	struct XorPairHash
+	{
+		std::size_t operator()(const std::pair<Node<int>, Node<int>>& pair) const
+		{
+			return std::hash<Node<int>>{}(pair.first) ^ std::hash<Node<int>>{}(pair.second);
+		}
+	};
+
+	// Whether every edge of [graph] between two of [components] goes from a later one to an earlier one
+	template <typename T>
+	bool IsReverseTopological(const CompactGraph<T>& graph, const std::vector<std::vector<int>>& components)
+	{
+		std::vector<int> componentOf(graph.vertexCount());
+		for (int component = 0; component < static_cast<int>(components.size()); component++)
+		{
+			for (const int vertex : components[component])
+			{
+				componentOf[vertex] = component;
+			}
+		}
+		for (int vertex = 0; vertex < graph.vertexCount(); vertex++)
+		{
+			for (const int successor : graph.successors(vertex))
+			{
+				if (componentOf[successor] > componentOf[vertex])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// The edges of [graph] as pairs of node indices, in order
+	std::vector<std::pair<int, int>> Edges(const Graph<CircuitScriptGraphNodeKind>& graph)
+	{
+		std::vector<std::pair<int, int>> edges;
+		for (const auto& [node, successors] : graph.adjacency())
+		{
+			for (const auto& successor : successors)
+			{
+				edges.emplace_back(node.index, successor.index);
+			}
+		}
+		std::ranges::sort(edges);
+		return edges;
+	}
+
+	template <typename Map>
+	void PairLookups(std::ostream& out, const char* name, const std::vector<std::pair<Node<int>, Node<int>>>& keys, const std::vector<std::pair<Node<int>, Node<int>>>& queries)
+	{
+		Map map;
+		const auto insertion = Milliseconds([&]
+			{
+				for (std::size_t i = 0; i < keys.size(); i++)
+				{
+					map.insert_or_assign(keys[i], static_cast<int>(i));
+				}
+			});
+		long long sum = 0;
+		const auto lookup = Milliseconds([&]
+			{
+				for (const auto& key : queries)
+				{
+					if (const auto itr = map.find(key); itr != map.end())
+					{
+						sum += itr->second;
+					}
+				}
+			});
+		out << "  " << name << ": insert " << insertion << " ms, lookup " << lookup << " ms (checksum " << sum << ")" << std::endl;
+	}
+}
+
+void CircuitCalculator::Benchmarks::StrongComponentsScaling(std::ostream& out, const int clusterCount, const int clusterSize)
+{
+	std::mt19937 random(20221017);
+	Graph<int> graph;
+	const auto size = clusterCount * clusterSize;
+	const auto node = [](const int vertex) { return Node<int>(vertex, vertex); };
+	for (int cluster = 0; cluster < clusterCount; cluster++)
+	{
+		const auto first = cluster * clusterSize;
+		std::uniform_int_distribution<int> inside(first, first + clusterSize - 1);
+		for (int vertex = first; vertex < first + clusterSize; vertex++)
+		{
+			// a ring keeps the cluster strongly connected, the chords make it look like a mesh
+			graph.addEdge(node(vertex), node(vertex + 1 < first + clusterSize ? vertex + 1 : first));
+			graph.addEdge(node(vertex), node(inside(random)));
+			graph.addEdge(node(vertex), node(inside(random)));
+		}
+		if (cluster + 1 < clusterCount)
+		{
+			std::uniform_int_distribution<int> later(first + clusterSize, size - 1);
+			for (int wire = 0; wire < clusterSize / 10; wire++)
+			{
+				graph.addEdge(node(inside(random)), node(later(random)));
+			}
+		}
+	}
+	const CompactGraph compactGraph(graph);
+	out << "strong components of " << compactGraph.vertexCount() << " vertices and " << compactGraph.edgeCount() << " edges" << std::endl;
+
+	std::vector<std::vector<int>> expected;
+	const auto sequential = Milliseconds([&] { expected = StrongComponents(compactGraph).denseStrongComponents(); });
+	// the engines may order the independent components differently, so they are compared as sets, and the order is checked
+	// on its own
+	const auto byLeastVertex = [](const std::vector<int>& lhs, const std::vector<int>& rhs) { return lhs.front() < rhs.front(); };
+	std::ranges::sort(expected, byLeastVertex);
+	out << "  sequential Tarjan: " << sequential << " ms, " << expected.size() << " components" << std::endl;
+
+	for (const auto threads : { 1, 2, 4, 8, 16 })
+	{
+		WorkStealingThreadPool pool(threads);
+		ParallelStrongComponents engine(compactGraph, pool);
+		std::vector<std::vector<int>> components;
+		const auto elapsed = Milliseconds([&] { components = engine.denseStrongComponents(); });
+		const auto ordered = IsReverseTopological(compactGraph, components);
+		std::ranges::sort(components, byLeastVertex);
+		out << "  " << threads << " threads: " << elapsed << " ms, speedup " << sequential / elapsed
+			<< (components == expected ? "" : ", MISMATCH") << (ordered ? "" : ", NOT REVERSE TOPOLOGICAL") << std::endl;
+	}
+}
+
+void CircuitCalculator::Benchmarks::PathTableLookups(std::ostream& out, const int vertexCount)
+{
+	std::vector<std::pair<Node<int>, Node<int>>> keys;
+	keys.reserve(static_cast<std::size_t>(vertexCount) * vertexCount);
+	for (int start = 0; start < vertexCount; start++)
+	{
+		for (int end = 0; end < vertexCount; end++)
+		{
+			if (start != end)
+			{
+				keys.emplace_back(Node(start, start), Node(end, end));
+			}
+		}
+	}
+	// half of the queries hit, the other half ask for the end points of nodes that are not in the table
+	std::vector<std::pair<Node<int>, Node<int>>> queries(keys);
+	for (std::size_t i = 0; i < queries.size(); i += 2)
+	{
+		queries[i].second.index += vertexCount;
+	}
+	std::ranges::shuffle(queries, std::mt19937(20221017));
+	out << "path table of " << keys.size() << " pairs, " << queries.size() << " lookups" << std::endl;
+
+	PairLookups<std::unordered_map<std::pair<Node<int>, Node<int>>, int, XorPairHash>>(out, "unordered_map, XOR pair hash", keys, queries);
+	PairLookups<std::unordered_map<std::pair<Node<int>, Node<int>>, int>>(out, "unordered_map, mixing pair hash", keys, queries);
+	PairLookups<FlatHashMap<std::pair<Node<int>, Node<int>>, int>>(out, "FlatHashMap", keys, queries);
+}
+
+void CircuitCalculator::Benchmarks::NumericLiterals(std::ostream& out, const int literalCount)
+{
+	// std::stod does not know the SI multipliers, it gets the literals without them and the multiplier is applied afterwards
+	constexpr const char* literals[] = { "4.7k", "470u", "1e-9", "12.5", "2.2E+3", "50", "0.33", "10n", "1.5M", "68p" };
+	constexpr double multipliers[] = { 1E3, 1E-6, 1, 1, 1, 1, 1, 1E-9, 1E6, 1E-12 };
+	std::string script;
+	for (int i = 0; i < literalCount; i++)
+	{
+		script += literals[i % std::size(literals)];
+		script += i % 16 == 15 ? '\n' : ' ';
+	}
+	out << "numeric literals: " << literalCount << ", " << script.size() << " bytes" << std::endl;
+
+	double sum = 0;
+	const auto lexed = Milliseconds([&]
+		{
+			CircuitScriptLexer lexer(script);
+			while (const auto token = lexer.nextToken())
+			{
+				sum += CircuitScriptLexer::numberValue(token->text);
+			}
+		});
+	out << "  lexer + from_chars: " << lexed << " ms, " << literalCount / lexed * 1000 << " literals/s (checksum " << sum << ")" << std::endl;
+
+	sum = 0;
+	const auto converted = Milliseconds([&]
+		{
+			for (int i = 0; i < literalCount; i++)
+			{
+				const std::string_view literal = literals[i % std::size(literals)];
+				const auto multiplier = multipliers[i % std::size(multipliers)];
+				sum += std::stod(std::string(multiplier == 1 ? literal : literal.substr(0, literal.size() - 1))) * multiplier;
+			}
+		});
+	out << "  std::stod on copies, without lexing: " << converted << " ms, " << literalCount / converted * 1000 << " literals/s (checksum " << sum << ")" << std::endl;
+}
+
+void CircuitCalculator::Benchmarks::ParsingScaling(std::ostream& out, const int unitCount)
+{
+	std::mt19937 random(20221017);
+	std::uniform_int_distribution<int> unit(0, unitCount - 1);
+	std::string script = "source = power(10, 50)\n";
+	for (int i = 0; i < unitCount; i++)
+	{
+		script += "r" + std::to_string(i) + " = resistor(4.7k)\n";
+	}
+	script += "connect(source, r0)\n";
+	for (int i = 0; i + 1 < unitCount; i++)
+	{
+		script += "connect(r" + std::to_string(i) + ", r" + std::to_string(i + 1) + ")\n";
+		script += "connect(r" + std::to_string(i) + ", r" + std::to_string(unit(random)) + ")\n";
+	}
+	out << "parsing a netlist of " << unitCount << " units, " << script.size() << " bytes" << std::endl;
+
+	Graph<CircuitScriptGraphNodeKind> expected;
+	const auto sequential = Milliseconds([&] { expected = CircuitScriptParser(CircuitScriptLexer(script)).parse(); });
+	const auto expectedEdges = Edges(expected);
+	out << "  CircuitScriptParser: " << sequential << " ms, " << expectedEdges.size() << " edges" << std::endl;
+
+	for (const auto threads : { 1, 2, 4, 8, 16 })
+	{
+		WorkStealingThreadPool pool(threads);
+		Graph<CircuitScriptGraphNodeKind> graph;
+		const auto elapsed = Milliseconds([&] { graph = CircuitScriptParallelParser(script, pool).parse(); });
+		out << "  " << threads << " threads: " << elapsed << " ms, speedup " << sequential / elapsed
+			<< (Edges(graph) == expectedEdges ? "" : ", MISMATCH") << std::endl;
+	}
+}
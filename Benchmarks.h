@@ -0,0 +1,43 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/Benchmarks.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <ostream>
+
+// Micro benchmarks of the parts of the calculator whose running time matters on large circuits, run by passing
+// --benchmark <name> to the executable
+namespace CircuitCalculator::Benchmarks
+{
+	// Time ParallelStrongComponents with 1, 2, 4, 8 and 16 threads against the sequential Tarjan on a synthetic netlist of
+	// [clusterCount] clusters of [clusterSize] units each, the clusters are strongly connected inside and only wired forward
+	// between each other, so the graph has many large strong components
+	void StrongComponentsScaling(std::ostream& out, int clusterCount = 400, int clusterSize = 2500);
+
+	// Time the insertion and the lookup of every ordered pair of [vertexCount] nodes, the keys of the path table of
+	// CircuitGraphEvaluator, in std::unordered_map with the XOR pair hash it used to have, in std::unordered_map with the
+	// current pair hash, and in FlatHashMap
+	void PathTableLookups(std::ostream& out, int vertexCount = 400);
+
+	// Time lexing a script of [literalCount] numeric literals, plain, scientific and with SI multipliers, and converting them
+	// with CircuitScriptLexer::numberValue, against converting copies of the same literals with std::stod
+	void NumericLiterals(std::ostream& out, int literalCount = 1000000);
+
+	// Time CircuitScriptParallelParser with 1, 2, 4, 8 and 16 threads against CircuitScriptParser on a synthetic netlist of
+	// [unitCount] resistors, every one declared on a line of its own and connected to the next one and to a random one
+	void ParsingScaling(std::ostream& out, int unitCount = 1000000);
+}
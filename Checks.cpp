@@ -0,0 +1,487 @@
+﻿#include "Checks.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CircuitExceptions.h"
+#include "CircuitGraphEvaluator.h"
+#include "CircuitGraphValidator.h"
+#include "CircuitScriptLexer.h"
+#include "CircuitScriptParallelParser.h"
+#include "CircuitScriptParser.h"
+#include "CircuitScriptSource.h"
+#include "FlatHashMap.h"
+#include "Impedance.h"
+#include "ParseException.h"
+#include "WorkStealingThreadPool.h"
+
+namespace
+{
+	using namespace CircuitCalculator::Impedance;
+
+	// A circuit whose impedance between the terminals of its power supply is known, as a function of the angular frequency
+	struct FixedCircuit
+	{
+		const char* name;
+		std::string script;
+		std::function<std::complex<double>(double)> impedance;
+		// a unit whose value the session changes, and the value it is changed to
+		const char* updated;
+		double value;
+	};
+
+	std::vector<FixedCircuit> FixedCircuits()
+	{
+		return {
+			{
+				"series",
+				"p = power(10, 50)\n"
+				"a = resistor(4.7k)\n"
+				"b = inductor(20)\n"
+				"c = capacitor(10)\n"
+				"connect(p, a)\nconnect(a, b)\nconnect(b, c)\nconnect(c, p)\n",
+				[](const double w) { return Resistor(4.7E3) + Inductor(20, w) + Capacitor(10, w); },
+				"b", 35
+			},
+			{
+				"parallel",
+				"p = power(10, 50)\n"
+				"a = resistor(1)\n"
+				"b = resistor(2)\n"
+				"c = capacitor(100)\n"
+				"d = inductor(50)\n"
+				"e = resistor(3)\n"
+				"connect(p, a)\nconnect(a, b)\nconnect(a, c)\nconnect(b, d)\nconnect(c, d)\nconnect(d, e)\nconnect(e, p)\n",
+				[](const double w) { return Resistor(1) + Parallel(Resistor(2), Capacitor(100, w)) + Inductor(50, w) + Resistor(3); },
+				"b", 7
+			},
+			{
+				"nested",
+				"p = power(10, 50)\n"
+				"a = resistor(1)\n"
+				"b = resistor(10)\n"
+				"c = capacitor(22)\n"
+				"d = inductor(5)\n"
+				"e = capacitor(47)\n"
+				"f = inductor(100)\n"
+				"g = resistor(2)\n"
+				"h = resistor(3)\n"
+				"connect(p, a)\nconnect(a, b)\nconnect(a, c)\nconnect(b, d)\nconnect(d, e)\nconnect(d, f)\nconnect(e, g)\n"
+				"connect(f, g)\nconnect(g, h)\nconnect(c, h)\nconnect(h, p)\n",
+				[](const double w)
+				{
+					const auto inner = Resistor(10) + Inductor(5, w) + Parallel(Capacitor(47, w), Inductor(100, w)) + Resistor(2);
+					return Resistor(1) + Parallel(inner, Capacitor(22, w)) + Resistor(3);
+				},
+				"e", 10
+			},
+			{
+				"grounded",
+				"p = power(10, 50)\n"
+				"a = resistor(5)\n"
+				"g = ground()\n"
+				"b = inductor(10)\n"
+				"connect(p, a)\nconnect(a, g)\nconnect(g, b)\nconnect(b, p)\n",
+				[](const double w) { return Resistor(5) + Inductor(10, w); },
+				"a", 0.5
+			}
+		};
+	}
+
+	// The Wheatstone bridge, b-c belongs to no series or parallel part
+	constexpr auto BridgeCircuit =
+		"p = power(10, 50)\n"
+		"a = resistor(1)\nb = resistor(2)\nc = resistor(3)\nd = resistor(4)\n"
+		"connect(p, a)\nconnect(a, b)\nconnect(a, c)\nconnect(b, c)\nconnect(b, d)\nconnect(c, d)\nconnect(d, p)\n";
+
+	bool Close(const std::complex<double> actual, const std::complex<double> expected)
+	{
+		return std::abs(actual - expected) <= 1E-9 * std::max(1.0, std::abs(expected));
+	}
+
+	// [script] with the unit declared as [tag] set to [value]
+	std::string WithValue(std::string script, const std::string& tag, const double value)
+	{
+		const auto begin = script.find('(', script.find('\n' + tag + " = ")) + 1;
+		return script.replace(begin, script.find(')', begin) - begin, std::to_string(value));
+	}
+
+	CircuitGraphEvaluator Evaluator(const std::string& script)
+	{
+		CircuitScriptParser parser{ CircuitScriptLexer(script) };
+		const auto graph = parser.parse();
+		CircuitGraphValidator(graph, parser.components()).validate();
+		return CircuitGraphEvaluator(graph, parser.components());
+	}
+
+	// Evaluates the NumPy form of an equation, which only consists of numbers, imaginary numbers, I, parentheses and the
+	// four operators, with the given current
+	class NumPyExpression
+	{
+		std::string_view text;
+		std::size_t position = 0;
+		std::complex<double> current;
+
+		void skipBlanks()
+		{
+			while (position < text.size() && text[position] == ' ')
+			{
+				position++;
+			}
+		}
+
+		bool accept(const char c)
+		{
+			skipBlanks();
+			if (position < text.size() && text[position] == c)
+			{
+				position++;
+				return true;
+			}
+			return false;
+		}
+
+		std::complex<double> factor()
+		{
+			if (accept('-'))
+			{
+				return -factor();
+			}
+			if (accept('('))
+			{
+				const auto value = sum();
+				return accept(')') ? value : std::numeric_limits<double>::quiet_NaN();
+			}
+			if (accept('I'))
+			{
+				return current;
+			}
+			double number;
+			const auto [end, error] = std::from_chars(text.data() + position, text.data() + text.size(), number);
+			if (error != std::errc())
+			{
+				return std::numeric_limits<double>::quiet_NaN();
+			}
+			position = end - text.data();
+			return accept('j') ? std::complex<double>(0, number) : std::complex<double>(number, 0);
+		}
+
+		std::complex<double> product()
+		{
+			auto value = factor();
+			while (true)
+			{
+				if (accept('*'))
+				{
+					value *= factor();
+				}
+				else if (accept('/'))
+				{
+					value /= factor();
+				}
+				else
+				{
+					return value;
+				}
+			}
+		}
+
+		std::complex<double> sum()
+		{
+			auto value = product();
+			while (true)
+			{
+				if (accept('+'))
+				{
+					value += product();
+				}
+				else if (accept('-'))
+				{
+					value -= product();
+				}
+				else
+				{
+					return value;
+				}
+			}
+		}
+	public:
+		NumPyExpression(const std::string_view text, const std::complex<double> current) : text(text), current(current)
+		{
+		}
+
+		// NaN if the text is malformed
+		std::complex<double> value()
+		{
+			const auto result = sum();
+			skipBlanks();
+			return position == text.size() ? result : std::numeric_limits<double>::quiet_NaN();
+		}
+	};
+
+	// What CircuitScriptParser makes of a script, the tags, kinds and values of the units at both ends of every edge, or
+	// the message of the error it throws
+	std::string Outcome(const Graph<CircuitScriptGraphNodeKind>& graph, const CircuitComponentTable& components)
+	{
+		std::vector<std::pair<int, int>> edges;
+		for (const auto& [node, successors] : graph.adjacency())
+		{
+			for (const auto& successor : successors)
+			{
+				edges.emplace_back(node.index, successor.index);
+			}
+		}
+		std::ranges::sort(edges);
+		std::string outcome;
+		const auto unit = [&outcome, &components](const int index)
+		{
+			outcome += components.tag(index) + ':' + std::to_string(static_cast<int>(components.kind(index))) + ':' + std::to_string(components.value(index));
+		};
+		for (const auto& [from, to] : edges)
+		{
+			unit(from);
+			outcome += "->";
+			unit(to);
+			outcome += '\n';
+		}
+		return outcome;
+	}
+
+	template <typename Parse>
+	std::string Outcome(Parse&& parse)
+	{
+		try
+		{
+			return parse();
+		}
+		catch (const ParseException& e)
+		{
+			return std::string("error ") + e.what();
+		}
+	}
+
+	// A netlist of [unitCount] resistors with long names in a chain, long enough to be split into many pieces, with [error]
+	// put in place of the statement at each of [errorLines]
+	std::string Netlist(const int unitCount, const std::vector<int>& errorLines, const std::string& error)
+	{
+		std::vector<std::string> lines{ "source = power(230, 50)" };
+		for (int i = 0; i < unitCount; i++)
+		{
+			lines.push_back("longresistorname" + std::to_string(i) + " = resistor(" + std::to_string(i % 9 + 1) + ".5k)");
+		}
+		lines.emplace_back("connect(source, longresistorname0)");
+		for (int i = 0; i + 1 < unitCount; i++)
+		{
+			lines.push_back("connect(longresistorname" + std::to_string(i) + ",   longresistorname" + std::to_string(i + 1) + ")");
+		}
+		lines.push_back("connect(longresistorname" + std::to_string(unitCount - 1) + ", source)");
+		for (const auto line : errorLines)
+		{
+			lines[line] = error;
+		}
+		std::string script;
+		for (const auto& line : lines)
+		{
+			script += line + '\n';
+		}
+		return script;
+	}
+
+	// Report a case, returns 1 if it failed
+	int Report(std::ostream& out, const std::string& name, const bool passed)
+	{
+		out << "  " << name << (passed ? "" : ", MISMATCH") << std::endl;
+		return passed ? 0 : 1;
+	}
+
+	// The hash that puts every key in one of eight home slots
+	struct CollidingHash
+	{
+		std::size_t operator()(const int key) const
+		{
+			return static_cast<std::size_t>(key % 8);
+		}
+	};
+}
+
+int CircuitCalculator::Checks::Evaluation(std::ostream& out)
+{
+	out << "evaluation of fixed circuits" << std::endl;
+	auto failures = 0;
+	const auto supply = AngularFrequency(50);
+	for (const auto& circuit : FixedCircuits())
+	{
+		const std::string name = circuit.name;
+		auto evaluator = Evaluator(circuit.script);
+		const auto expected = circuit.impedance(supply);
+
+		const auto [impedance, current] = evaluator.evaluate();
+		failures += Report(out, name + " evaluate", Close(impedance, expected) && Close(current, 10.0 / expected));
+
+		const std::vector<double> frequencies{ 50, 1000 };
+		const auto sweep = evaluator.sweep(frequencies);
+		auto swept = true;
+		for (std::size_t f = 0; f < frequencies.size(); f++)
+		{
+			swept = swept && Close(std::polar(sweep.magnitudes[f], sweep.phases[f]), circuit.impedance(AngularFrequency(frequencies[f])));
+		}
+		failures += Report(out, name + " sweep", swept);
+
+		// the NumPy form is the whole equation, the voltage of the supply included, so it vanishes at the current drawn, up to
+		// the rounding of the impedances, which the equations write with two decimals
+		const auto residual = NumPyExpression(evaluator.generateEquation(EquationFormat::NumPy), current).value();
+		failures += Report(out, name + " numpy", std::abs(residual) <= 1E-3 * 10);
+
+		auto session = evaluator.session();
+		const auto initial = session.result().impedance;
+		session.update(session.unit(circuit.updated), circuit.value);
+		const auto updated = session.result().impedance;
+		const auto fresh = Evaluator(WithValue(circuit.script, circuit.updated, circuit.value)).evaluate().impedance;
+		session.updateFrequency(1000);
+		const auto moved = session.result().impedance;
+		auto freshEvaluator = Evaluator(WithValue(circuit.script, circuit.updated, circuit.value));
+		const auto freshSweep = freshEvaluator.sweep(std::vector<double>{ 1000 });
+		failures += Report(out, name + " session", Close(initial, expected) && Close(updated, fresh)
+			&& Close(moved, std::polar(freshSweep.magnitudes[0], freshSweep.phases[0])));
+	}
+
+	auto rejected = false;
+	try
+	{
+		Evaluator(BridgeCircuit).evaluate();
+	}
+	catch (const NonSeriesParallelCircuitException&)
+	{
+		rejected = true;
+	}
+	failures += Report(out, "bridge rejected", rejected);
+	return failures;
+}
+
+int CircuitCalculator::Checks::Parsing(std::ostream& out)
+{
+	out << "parallel and chunked parsing against CircuitScriptParser" << std::endl;
+	std::vector<std::pair<std::string, std::string>> scripts;
+	for (const auto& circuit : FixedCircuits())
+	{
+		scripts.emplace_back(circuit.name, circuit.script);
+	}
+	scripts.emplace_back("netlist", Netlist(300, {}, ""));
+	scripts.emplace_back("undefined unit", Netlist(300, { 400 }, "connect(x, y)"));
+	scripts.emplace_back("lexical error", Netlist(300, { 150 }, "q = resistor(1) $"));
+	scripts.emplace_back("two errors", Netlist(300, { 120, 450 }, "r = resistor(1, 2)"));
+	scripts.emplace_back("lexical error after parse error", Netlist(300, { 100, 101 }, "connect(a b)\nq = $"));
+	scripts.emplace_back("number out of range", Netlist(300, { 200 }, "q = resistor(1e999)"));
+	scripts.emplace_back("missing parenthesis", Netlist(300, { 250 }, "q = resistor(1"));
+
+	auto failures = 0;
+	WorkStealingThreadPool pool(3);
+	for (const auto& [name, script] : scripts)
+	{
+		const auto expected = Outcome([&script]
+			{
+				CircuitScriptParser parser{ CircuitScriptLexer(script) };
+				const auto graph = parser.parse();
+				return Outcome(graph, parser.components());
+			});
+		auto passed = true;
+		for (const std::size_t pieces : { 1, 2, 3, 5, 8, 16 })
+		{
+			passed = passed && Outcome([&script, &pool, pieces]
+				{
+					CircuitScriptParallelParser parser(script, pool, pieces);
+					const auto graph = parser.parse();
+					return Outcome(graph, parser.components());
+				}) == expected;
+		}
+		for (const std::size_t chunkSize : { 1, 2, 3, 7, 64 })
+		{
+			passed = passed && Outcome([&script, chunkSize]
+				{
+					CircuitScriptParser parser(CircuitScriptLexer(std::make_unique<CircuitScriptStringSource>(script, chunkSize)));
+					const auto graph = parser.parse();
+					return Outcome(graph, parser.components());
+				}) == expected;
+		}
+		failures += Report(out, name + (expected.starts_with("error") ? " (" + expected + ")" : ""), passed);
+	}
+	return failures;
+}
+
+int CircuitCalculator::Checks::NumericLiterals(std::ostream& out)
+{
+	out << "numeric literals" << std::endl;
+	const std::pair<const char*, double> literals[] = {
+		{ "47", 47 }, { "0.5", 0.5 }, { "1.5e3", 1.5E3 }, { "2E-2", 2E-2 }, { "8f", 8E-15 }, { "3p", 3E-12 }, { "7n", 7E-9 },
+		{ "4.7u", 4.7E-6 }, { "10m", 1E-2 }, { "4.7k", 4.7E3 }, { "2.2M", 2.2E6 }, { "5G", 5E9 }
+	};
+	auto failures = 0;
+	for (const auto& [literal, value] : literals)
+	{
+		failures += Report(out, literal, std::abs(CircuitScriptLexer::numberValue(literal) - value) <= 1E-12 * value);
+	}
+	auto thrown = false;
+	try
+	{
+		CircuitScriptLexer::numberValue("1e999");
+	}
+	catch (const ParseException&)
+	{
+		thrown = true;
+	}
+	failures += Report(out, "1e999 out of range", thrown);
+	return failures;
+}
+
+int CircuitCalculator::Checks::FlatHashMapErasure(std::ostream& out)
+{
+	out << "FlatHashMap against std::unordered_map" << std::endl;
+	std::mt19937 random(20221017);
+	std::uniform_int_distribution<int> keys(0, 255);
+	FlatHashMap<int, int, CollidingHash> map;
+	std::unordered_map<int, int> expected;
+	auto passed = true;
+	for (int step = 0; step < 20000 && passed; step++)
+	{
+		const auto key = keys(random);
+		if (random() % 3 == 0)
+		{
+			passed = map.erase(key) == expected.erase(key);
+		}
+		else
+		{
+			map.insert_or_assign(key, step);
+			expected.insert_or_assign(key, step);
+		}
+		if (step % 100 == 0)
+		{
+			passed = passed && map.size() == expected.size();
+			for (int k = 0; k <= 255 && passed; k++)
+			{
+				const auto itr = map.find(k);
+				const auto other = expected.find(k);
+				passed = (itr == map.end()) == (other == expected.end()) && (itr == map.end() || itr->second == other->second);
+			}
+		}
+	}
+	std::size_t iterated = 0;
+	for ([[maybe_unused]] const auto& element : map)
+	{
+		iterated++;
+	}
+	return Report(out, "random insertions and erasures", passed && iterated == expected.size());
+}
+
+int CircuitCalculator::Checks::All(std::ostream& out)
+{
+	return Evaluation(out) + Parsing(out) + NumericLiterals(out) + FlatHashMapErasure(out);
+}
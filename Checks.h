@@ -0,0 +1,45 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/Checks.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <ostream>
+
+// Self checks of the parts of the calculator that have more than one way to get the same answer, run by passing --check to
+// the executable. Every check prints a line per case, marked MISMATCH when the answers disagree, and returns the number of
+// mismatches
+namespace CircuitCalculator::Checks
+{
+	// Compare evaluate(), sweep() and a session of CircuitGraphEvaluator, and the NumPy form of the equation evaluated with
+	// the current from evaluate(), against the impedances worked out by hand for a few fixed circuits, and check that a
+	// circuit with a bridge is rejected
+	int Evaluation(std::ostream& out);
+
+	// Compare CircuitScriptParallelParser with every number of pieces, and CircuitScriptParser reading the script in chunks
+	// of a few bytes, against CircuitScriptParser on the whole script, both on valid scripts and on scripts with errors
+	int Parsing(std::ostream& out);
+
+	// Compare CircuitScriptLexer::numberValue against the values of plain, scientific and SI literals
+	int NumericLiterals(std::ostream& out);
+
+	// Compare FlatHashMap against std::unordered_map over random insertions and erasures with a hash that collides a lot,
+	// so that erasing has to shift long probe sequences back
+	int FlatHashMapErasure(std::ostream& out);
+
+	// Run every check above
+	int All(std::ostream& out);
+}
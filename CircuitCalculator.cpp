@@ -1,13 +1,47 @@
-#include <iostream>
+﻿#include <iostream>
+#include <memory>
+#include <string_view>
 
+#include "Benchmarks.h"
+#include "Checks.h"
 #include "CircuitGraphEvaluator.h"
 #include "CircuitGraphValidator.h"
 #include "CircuitScriptLexer.h"
 #include "CircuitScriptParser.h"
+#include "CircuitScriptSource.h"
 #include "Graph.h"
 
-int main()
+int main(const int argc, char* argv[])
 {
+	if (argc == 2 && std::string_view(argv[1]) == "--check")
+	{
+		return CircuitCalculator::Checks::All(std::cout) == 0 ? 0 : 1;
+	}
+	if (argc == 3 && std::string_view(argv[1]) == "--benchmark")
+	{
+		if (std::string_view(argv[2]) == "scc")
+		{
+			CircuitCalculator::Benchmarks::StrongComponentsScaling(std::cout);
+			return 0;
+		}
+		if (std::string_view(argv[2]) == "pathtable")
+		{
+			CircuitCalculator::Benchmarks::PathTableLookups(std::cout);
+			return 0;
+		}
+		if (std::string_view(argv[2]) == "literals")
+		{
+			CircuitCalculator::Benchmarks::NumericLiterals(std::cout);
+			return 0;
+		}
+		if (std::string_view(argv[2]) == "parse")
+		{
+			CircuitCalculator::Benchmarks::ParsingScaling(std::cout);
+			return 0;
+		}
+		std::cerr << "unknown benchmark " << argv[2] << std::endl;
+		return 1;
+	}
 	/*CircuitScriptLexer lexer(R""""(
 u0 = power(10, 50)
 u1 = resistor(4.7)
@@ -32,7 +66,24 @@ connect(u9, u6)
 connect(u5, u2)
 connect(u6, u2)
 connect(u2, u0))"""");*/
-	CircuitScriptLexer lexer(R"(
+	// the script is read from the file given on the command line, from the standard input if it is -, or else the sample below
+	// is used. With --mmap the file is mapped into memory instead of being read
+	std::unique_ptr<CircuitScriptSource> source;
+	if (argc == 2 && std::string_view(argv[1]) == "-")
+	{
+		source = std::make_unique<CircuitScriptStreamSource>(std::cin);
+	}
+	else if (argc == 2)
+	{
+		source = std::make_unique<CircuitScriptStreamSource>(std::string(argv[1]));
+	}
+	else if (argc == 3 && std::string_view(argv[1]) == "--mmap")
+	{
+		source = std::make_unique<CircuitScriptMappedFileSource>(argv[2]);
+	}
+	else
+	{
+		source = std::make_unique<CircuitScriptStringSource>(R"(
 u2 = power(10, 50)
 u3 = resistor(4.7)
 u6 = resistor(5)
@@ -54,10 +105,14 @@ connect(u8, u4)
 connect(u7, u4)
 connect(u4, u2)
 )");
-	CircuitScriptParser parser(lexer);
+	}
+	CircuitScriptParser parser(CircuitScriptLexer(std::move(source)));
 	auto graph = parser.parse();
-	CircuitGraphValidator validator(graph);
+	CircuitGraphValidator validator(graph, parser.components());
 	validator.validate();
-	CircuitGraphEvaluator evaluator(graph);
-	std::cout << evaluator.generateEquation() << std::endl;
+	CircuitGraphEvaluator evaluator(graph, parser.components());
+	evaluator.generateEquation(std::cout);
+	std::cout << std::endl;
+	const auto [impedance, current] = evaluator.evaluate();
+	std::cout << "Z = " << impedance << ", I = " << current << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,139 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/CircuitComponentTable.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "CircuitScriptGraphNode.h"
+
+struct PowerComponent
+{
+	double voltageInVolt;
+	double frequencyInHz;
+};
+
+struct ResistorComponent
+{
+	double resistanceInO;
+};
+
+struct CapacitorComponent
+{
+	double capacitanceInF;
+};
+
+struct GroundComponent
+{
+};
+
+struct InductorComponent
+{
+	double inductanceInH;
+};
+
+// The alternatives are in the same order as CircuitScriptGraphNodeKind, so that the index of the variant is the kind
+using CircuitComponent = std::variant<PowerComponent, ResistorComponent, CapacitorComponent, GroundComponent, InductorComponent>;
+
+inline CircuitScriptGraphNodeKind ComponentKind(const CircuitComponent& component)
+{
+	return static_cast<CircuitScriptGraphNodeKind>(component.index());
+}
+
+// The units of a circuit stored by value and keyed by the index of their node, the nodes of the graph only carry the kind
+// of their unit, so that reading the kind or the value of a unit is an array access and no unit lives on the heap
+class CircuitComponentTable
+{
+	std::vector<CircuitComponent> components;
+	std::vector<std::string> tags;
+	std::vector<bool> declared;
+	int powerIndex = -1;
+public:
+	void add(const int index, const CircuitComponent& component, const std::string& tag)
+	{
+		if (index >= static_cast<int>(components.size()))
+		{
+			components.resize(index + 1, GroundComponent{});
+			tags.resize(index + 1);
+			declared.resize(index + 1);
+		}
+		components[index] = component;
+		tags[index] = tag;
+		declared[index] = true;
+		if (std::holds_alternative<PowerComponent>(component))
+		{
+			powerIndex = index;
+		}
+	}
+
+	bool contains(const int index) const
+	{
+		return index >= 0 && index < static_cast<int>(declared.size()) && declared[index];
+	}
+
+	const CircuitComponent& operator[](const int index) const
+	{
+		return components[index];
+	}
+
+	CircuitScriptGraphNodeKind kind(const int index) const
+	{
+		return ComponentKind(components[index]);
+	}
+
+	// The resistance, capacitance or inductance of the unit, 0 for the power supply and grounds
+	double value(const int index) const
+	{
+		switch (kind(index))
+		{
+		case CircuitScriptGraphNodeKind::Resistor:
+			return std::get<ResistorComponent>(components[index]).resistanceInO;
+		case CircuitScriptGraphNodeKind::Capacitor:
+			return std::get<CapacitorComponent>(components[index]).capacitanceInF;
+		case CircuitScriptGraphNodeKind::Inductor:
+			return std::get<InductorComponent>(components[index]).inductanceInH;
+		case CircuitScriptGraphNodeKind::Power:
+		case CircuitScriptGraphNodeKind::Ground:
+			break;
+		}
+		return 0;
+	}
+
+	const std::string& tag(const int index) const
+	{
+		return tags[index];
+	}
+
+	// The index of the power supply, -1 if there is none
+	int powerSupplyIndex() const
+	{
+		return powerIndex;
+	}
+
+	// The power supply, nullptr if there is none
+	const PowerComponent* powerSupply() const
+	{
+		return powerIndex == -1 ? nullptr : &std::get<PowerComponent>(components[powerIndex]);
+	}
+
+	std::size_t size() const
+	{
+		return components.size();
+	}
+};
@@ -0,0 +1,180 @@
+﻿#include "CircuitEvaluationSession.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "EvaluationTape.h"
+#include "Impedance.h"
+
+void CircuitEvaluationSession::recompute(const int node)
+{
+	using namespace CircuitCalculator;
+
+	switch (const auto& current = tree.nodes[node]; current.kind)
+	{
+	case SeriesParallelNodeKind::Unit:
+		switch (kinds[current.unit])
+		{
+		case CircuitScriptGraphNodeKind::Resistor:
+			impedances[node] = Impedance::Resistor(values[current.unit]);
+			break;
+		case CircuitScriptGraphNodeKind::Capacitor:
+			impedances[node] = Impedance::Capacitor(values[current.unit], angularFrequency);
+			break;
+		case CircuitScriptGraphNodeKind::Inductor:
+			impedances[node] = Impedance::Inductor(values[current.unit], angularFrequency);
+			break;
+		case CircuitScriptGraphNodeKind::Power:
+		case CircuitScriptGraphNodeKind::Ground:
+			impedances[node] = {};
+			break;
+		}
+		break;
+	case SeriesParallelNodeKind::Series:
+	{
+		std::complex<double> sum;
+		for (const auto child : current.children)
+		{
+			sum += impedances[child];
+		}
+		impedances[node] = sum;
+		break;
+	}
+	case SeriesParallelNodeKind::Parallel:
+	{
+		std::complex<double> admittance;
+		auto shorted = 0;
+		for (const auto child : current.children)
+		{
+			if (impedances[child] == std::complex<double>())
+			{
+				shorted++;
+			}
+			else
+			{
+				admittance += 1.0 / impedances[child];
+			}
+		}
+		admittances[node] = admittance;
+		shortedChildren[node] = shorted;
+		impedances[node] = shorted > 0 ? std::complex<double>() : 1.0 / admittance;
+		break;
+	}
+	}
+}
+
+void CircuitEvaluationSession::applyDelta(const int node, const std::complex<double> before, const std::complex<double> after)
+{
+	const auto finite = [](const std::complex<double>& z) { return std::isfinite(z.real()) && std::isfinite(z.imag()); };
+	switch (tree.nodes[node].kind)
+	{
+	case SeriesParallelNodeKind::Series:
+		impedances[node] += after - before;
+		break;
+	case SeriesParallelNodeKind::Parallel:
+		for (const auto& [impedance, sign] : { std::pair{ before, -1 }, std::pair{ after, 1 } })
+		{
+			if (impedance == std::complex<double>())
+			{
+				shortedChildren[node] += sign;
+			}
+			else
+			{
+				admittances[node] += static_cast<double>(sign) / impedance;
+			}
+		}
+		impedances[node] = shortedChildren[node] > 0 ? std::complex<double>() : 1.0 / admittances[node];
+		break;
+	case SeriesParallelNodeKind::Unit:
+		break;
+	}
+	// an infinite impedance, e.g., a capacitor at 0 Hz, cannot be taken back out of a sum
+	if (!finite(before) || !finite(after) || !finite(impedances[node]) || !finite(admittances[node]))
+	{
+		recompute(node);
+	}
+}
+
+void CircuitEvaluationSession::record(const std::chrono::steady_clock::time_point start)
+{
+	const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	stats.updates++;
+	stats.lastLatency = latency;
+	stats.maxLatency = std::max(stats.maxLatency, latency);
+	stats.totalLatency += latency;
+}
+
+CircuitEvaluationSession::CircuitEvaluationSession(const CompactGraph<CircuitScriptGraphNodeKind>& graph, SeriesParallelTree tree, const CircuitComponentTable& components)
+	: tree(std::move(tree)), values(EvaluationTape::unitValues(graph, components)), leaves(graph.vertexCount(), -1)
+{
+	const auto* power = components.powerSupply();
+	voltageInVolt = power->voltageInVolt;
+	angularFrequency = CircuitCalculator::Impedance::AngularFrequency(power->frequencyInHz);
+	kinds.reserve(graph.vertexCount());
+	for (int vertex = 0; vertex < graph.vertexCount(); vertex++)
+	{
+		kinds.push_back(components.kind(graph.index(vertex)));
+		units.emplace(components.tag(graph.index(vertex)), vertex);
+	}
+	impedances.resize(this->tree.nodes.size());
+	admittances.resize(this->tree.nodes.size());
+	shortedChildren.resize(this->tree.nodes.size());
+	for (int node = 0; node < static_cast<int>(this->tree.nodes.size()); node++)
+	{
+		if (this->tree.nodes[node].kind == SeriesParallelNodeKind::Unit)
+		{
+			leaves[this->tree.nodes[node].unit] = node;
+		}
+		recompute(node);
+	}
+}
+
+int CircuitEvaluationSession::unit(const std::string& tag) const
+{
+	const auto itr = units.find(tag);
+	return itr == units.end() ? -1 : itr->second;
+}
+
+void CircuitEvaluationSession::update(const int unit, const double value)
+{
+	if (unit < 0 || unit >= static_cast<int>(values.size()))
+	{
+		throw std::out_of_range("No unit has the id " + std::to_string(unit));
+	}
+	if (leaves[unit] == -1)
+	{
+		throw std::invalid_argument("The power supply cannot be updated");
+	}
+	const auto start = std::chrono::steady_clock::now();
+	values[unit] = value;
+	auto node = leaves[unit];
+	auto before = impedances[node];
+	recompute(node);
+	// every node on the way up only sees the change of the child it is reached from
+	for (auto parent = tree.nodes[node].parent; parent != -1 && impedances[node] != before; node = parent, parent = tree.nodes[node].parent)
+	{
+		const auto parentBefore = impedances[parent];
+		applyDelta(parent, before, impedances[node]);
+		before = parentBefore;
+	}
+	record(start);
+}
+
+void CircuitEvaluationSession::updateFrequency(const double frequencyInHz)
+{
+	const auto start = std::chrono::steady_clock::now();
+	angularFrequency = CircuitCalculator::Impedance::AngularFrequency(frequencyInHz);
+	for (int node = 0; node < static_cast<int>(tree.nodes.size()); node++)
+	{
+		recompute(node);
+	}
+	record(start);
+}
+
+CircuitEvaluationResult CircuitEvaluationSession::result() const
+{
+	const auto impedance = impedances[tree.root()];
+	return { impedance, voltageInVolt / impedance };
+}
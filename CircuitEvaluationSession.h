@@ -0,0 +1,97 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/CircuitEvaluationSession.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <chrono>
+#include <complex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CircuitComponentTable.h"
+#include "CircuitScriptGraphNode.h"
+#include "CompactGraph.h"
+#include "SeriesParallelDecomposition.h"
+
+struct CircuitEvaluationResult
+{
+	// the equivalent impedance of everything but the power supply, in ohms
+	std::complex<double> impedance;
+	// the current that flows out of the power supply, in amperes
+	std::complex<double> current;
+};
+
+struct CircuitEvaluationSessionStatistics
+{
+	std::size_t updates = 0;
+	std::chrono::nanoseconds lastLatency{ 0 };
+	std::chrono::nanoseconds maxLatency{ 0 };
+	std::chrono::nanoseconds totalLatency{ 0 };
+};
+
+// Keeps the impedance of every node of the decomposition tree, so that changing the value of a single unit only recomputes
+// the nodes on the path from that unit to the root, instead of lexing, parsing, validating and evaluating the whole circuit
+// again. A series part keeps the sum of the impedances of its children and a parallel part the sum of their admittances,
+// so every node on the path takes the difference of one child in constant time, however many children it has. Every
+// update is timed, see statistics()
+class CircuitEvaluationSession
+{
+	SeriesParallelTree tree;
+	std::vector<CircuitScriptGraphNodeKind> kinds;
+	std::vector<double> values;
+	// the tree node of every unit, -1 for the power supply
+	std::vector<int> leaves;
+	std::unordered_map<std::string, int> units;
+	std::vector<std::complex<double>> impedances;
+	// the sum of the admittances of the children of every Parallel node, except those without impedance, which are counted
+	// in [shortedChildren] instead since they short the whole part
+	std::vector<std::complex<double>> admittances;
+	std::vector<int> shortedChildren;
+	double voltageInVolt;
+	double angularFrequency;
+	CircuitEvaluationSessionStatistics stats;
+
+	// Compute the impedance of [node] from scratch
+	void recompute(int node);
+
+	// Change the impedance of a child of [node] from [before] to [after], recomputes [node] if the difference is not finite
+	void applyDelta(int node, std::complex<double> before, std::complex<double> after);
+
+	void record(std::chrono::steady_clock::time_point start);
+public:
+	CircuitEvaluationSession(const CompactGraph<CircuitScriptGraphNodeKind>& graph, SeriesParallelTree tree, const CircuitComponentTable& components);
+
+	// The dense id of the unit declared with [tag], -1 if there is no such unit
+	int unit(const std::string& tag) const;
+
+	// Set the resistance, capacitance or inductance of the unit, depending on its kind, and recompute its ancestors, throws
+	// std::out_of_range if [unit] is not the id of a unit, e.g., -1 from [unit], and std::invalid_argument for the power
+	// supply, whose voltage and frequency are not the value of an impedance
+	void update(int unit, double value);
+
+	// Changing the frequency affects every capacitor and inductor, so the whole tree is recomputed, which also clears the
+	// rounding errors the differences of [update] have piled up in the sums. It is timed like [update]
+	void updateFrequency(double frequencyInHz);
+
+	CircuitEvaluationResult result() const;
+
+	const CircuitEvaluationSessionStatistics& statistics() const
+	{
+		return stats;
+	}
+};
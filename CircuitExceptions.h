@@ -19,6 +19,7 @@
 #pragma once
 #include <exception>
 #include <set>
+#include <utility>
 
 #include "CircuitScriptGraphNode.h"
 #include "Node.h"
@@ -26,9 +27,9 @@
 class UnreachableUnitException final : std::exception
 {
 public:
-	const std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>>& unreachable;
+	const std::set<Node<CircuitScriptGraphNodeKind>>& unreachable;
 
-	explicit UnreachableUnitException(const std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>>& unreachable)
+	explicit UnreachableUnitException(const std::set<Node<CircuitScriptGraphNodeKind>>& unreachable)
 		: std::exception("Unreachable units detected in the circuit"), unreachable(unreachable)
 	{
 	}
@@ -37,9 +38,9 @@ public:
 class UnitPartiallyConnectedException final : std::exception
 {
 public:
-	const std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>>& disconnected;
+	const std::set<Node<CircuitScriptGraphNodeKind>>& disconnected;
 
-	explicit UnitPartiallyConnectedException(const std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>>& disconnected)
+	explicit UnitPartiallyConnectedException(const std::set<Node<CircuitScriptGraphNodeKind>>& disconnected)
 		: std::exception("Units that are partially connected from the circuit detected"), disconnected(disconnected)
 	{
 	}
@@ -49,4 +50,15 @@ class NoPowerSupplyFoundException final : std::exception
 {
 public:
 	NoPowerSupplyFoundException() : std::exception("You must add at least one power supply") {}
+};
+
+class NonSeriesParallelCircuitException final : std::exception
+{
+public:
+	const std::set<Node<CircuitScriptGraphNodeKind>> irreducible;
+
+	explicit NonSeriesParallelCircuitException(std::set<Node<CircuitScriptGraphNodeKind>> irreducible)
+		: std::exception("Units that cannot be reduced into series or parallel parts detected in the circuit"), irreducible(std::move(irreducible))
+	{
+	}
 };
\ No newline at end of file
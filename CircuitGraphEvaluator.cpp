@@ -4,116 +4,295 @@
 #include <iomanip>
 #include <sstream>
 #include <numbers>
-#include <numeric>
 #include <ranges>
 
+#include "CircuitExceptions.h"
+#include "CompactGraph.h"
 #include "Utils.h"
 
-template<typename First, typename Second>
-struct std::hash<std::pair<First, Second>>
-{
-	std::size_t operator()(const std::pair<First, Second>& pair) const
-	{
-		return std::hash<First>{}(pair.first) ^ std::hash<Second>{}(pair.second);
-	}
-};
-
-std::string CircuitGraphEvaluator::impedance(const std::shared_ptr<CircuitScriptGraphNode>& unit)
+std::string CircuitGraphEvaluator::impedance(const int index)
 {
 	std::stringstream ss;
-	const auto power = std::dynamic_pointer_cast<CircuitScriptPowerGraphNode>(graph.vertices().begin()->data);
-	if (unit->kind == CircuitScriptGraphNodeKind::Power)
+	const auto* power = components.powerSupply();
+	switch (components.kind(index))
 	{
+	case CircuitScriptGraphNodeKind::Power:
 		ss << std::fixed << std::setprecision(2) << "-" << power->voltageInVolt << "";
-	}
-	else if (unit->kind == CircuitScriptGraphNodeKind::Resistor)
-	{
-		const auto resistor = std::dynamic_pointer_cast<CircuitScriptResistorGraphNode>(unit);
-		ss << std::fixed << std::setprecision(2) << resistor->resistanceInO;
-	}
-	else if (unit->kind == CircuitScriptGraphNodeKind::Capacitor)
-	{
-		const auto capacitor = std::dynamic_pointer_cast<CircuitScriptCapacitorGraphNode>(unit);
-		ss << std::fixed << std::setprecision(2) << "(-j" << 1 / (2 * std::numbers::pi * power->frequencyInHz * capacitor->capacitanceInF) * 1E06 << ")";
-	}
-	else if (unit->kind == CircuitScriptGraphNodeKind::Inductor)
-	{
-		const auto inductor = std::dynamic_pointer_cast<CircuitScriptInductorGraphNode>(unit);
-		ss << std::fixed << std::setprecision(2) << "j" << 2 * std::numbers::pi * power->frequencyInHz * inductor->inductanceInH * 1E-3;
+		break;
+	case CircuitScriptGraphNodeKind::Resistor:
+		ss << std::fixed << std::setprecision(2) << std::get<ResistorComponent>(components[index]).resistanceInO;
+		break;
+	case CircuitScriptGraphNodeKind::Capacitor:
+		ss << std::fixed << std::setprecision(2) << "(-j" << 1 / (2 * std::numbers::pi * power->frequencyInHz * std::get<CapacitorComponent>(components[index]).capacitanceInF) * 1E06 << ")";
+		break;
+	case CircuitScriptGraphNodeKind::Inductor:
+		ss << std::fixed << std::setprecision(2) << "j" << 2 * std::numbers::pi * power->frequencyInHz * std::get<InductorComponent>(components[index]).inductanceInH * 1E-3;
+		break;
+	case CircuitScriptGraphNodeKind::Ground:
+		break;
 	}
 	return ss.str();
 }
 
+ExpressionId CircuitGraphEvaluator::unitExpression(const int index)
+{
+	return index == components.powerSupplyIndex() ? expressions.source(impedance(index)) : expressions.impedance(impedance(index));
+}
+
 void CircuitGraphEvaluator::translateGraph()
 {
-	Graph<std::string> translatedGraph;
-	std::set<Node<std::string>> newGraphNodes;
-	for (const auto& vertex : graph.vertices())
+	// the translated node of every index, looked up once per edge instead of searched for
+	std::unordered_map<int, Node<ExpressionId>> newGraphNodes;
+	newGraphNodes.reserve(graph.adjacency().size());
+	for (const auto& vertex : std::views::keys(graph.adjacency()))
 	{
-		newGraphNodes.insert(Node(impedance(vertex.data), vertex.index));
+		newGraphNodes.emplace(vertex.index, Node(unitExpression(vertex.index), vertex.index));
 	}
+	Graph<ExpressionId> translatedGraph;
+	// in the order of the indices, the order of the edges decides which of the parallel groups are merged first
 	for (const auto& vertex : graph.vertices())
 	{
-		for (const auto& successor : graph.adjacencyList[vertex])
+		for (const auto& successor : graph.adjacency().at(vertex))
 		{
-			translatedGraph.addEdge(
-				*std::ranges::find_if(newGraphNodes, [&vertex](const auto& node) { return node.index == vertex.index; }),
-				*std::ranges::find_if(newGraphNodes, [&successor](const auto& node) { return node.index == successor.index; })
-			);
+			translatedGraph.addEdge(newGraphNodes.at(vertex.index), newGraphNodes.at(successor.index));
 		}
 	}
-	reducedGraph = translatedGraph;
+	reducedGraph = std::move(translatedGraph);
+	allNonTrivialPathsOfReducedGraph();
+}
+
+// Enumerate the paths between [start] and [end] of [compactGraph] (a snapshot of [reducedGraph]) into the path table
+void CircuitGraphEvaluator::updatePathTableEntry(const CompactGraph<ExpressionId>& compactGraph, PathSearchWorkspace& workspace, const int start, const int end)
+{
+	const auto key = std::make_pair(compactGraph.node(start), compactGraph.node(end));
+	std::vector<PathHandle> paths;
+	// the dense ids are only valid for this snapshot, the pool keeps the indices of the nodes, which never change
+	std::vector<int> indices;
+	compactGraph.forEachNonTrivialPath(start, end, workspace, [this, &paths, &indices, &compactGraph, &key](const std::span<const int> path)
+		{
+			indices.resize(path.size());
+			std::ranges::transform(path, indices.begin(), [&compactGraph](const int vertex) { return compactGraph.index(vertex); });
+			paths.push_back(pathPool.add(indices));
+			for (const auto index : indices)
+			{
+				pairsThrough[index].push_back(key);
+			}
+		});
+	if (paths.empty())
+	{
+		pathTable.erase(key);
+		return;
+	}
+	pathTable.insert_or_assign(key, std::move(paths));
 }
 
 // Get all non trivial paths, i.e., paths those who have intermediate nodes.
-// Returns a map whose key is the start and end node, value is all paths between start(exclusive) and end(exclusive).
-std::unordered_map<std::pair<Node<std::string>, Node<std::string>>, std::vector<std::vector<Node<std::string>>>> CircuitGraphEvaluator::allNonTrivialPathsOfReducedGraph()
+// Fills the path table, whose key is the start and end node, value is all paths between start(exclusive) and end(exclusive).
+void CircuitGraphEvaluator::allNonTrivialPathsOfReducedGraph()
 {
-	std::unordered_map<std::pair<Node<std::string>, Node<std::string>>, std::vector<std::vector<Node<std::string>>>> result;
-	for (const auto& start : reducedGraph.vertices())
+	pathTable.clear();
+	pairsThrough.clear();
+	pathPool.clear();
+	const auto& compactGraph = reducedGraph.compact();
+	PathSearchWorkspace workspace;
+	for (int start = 0; start < compactGraph.vertexCount(); start++)
 	{
-		for (const auto& end : reducedGraph.vertices())
+		for (int end = 0; end < compactGraph.vertexCount(); end++)
 		{
 			// we don't want to calculate the path from a single node to itself.
 			if (start != end)
 			{
-				if (const auto& paths = reducedGraph.nonTrivialPaths(start, end); !paths.empty())
+				updatePathTableEntry(compactGraph, workspace, start, end);
+			}
+		}
+	}
+}
+
+// Bring the path table up to date after the nodes in [removed] have been merged into the nodes in [added]
+// The paths that avoid the removed nodes are still there, and every new path through an added node replaces an old path through
+// the removed nodes it stands for. So only the entries that had a path through a removed node, which are found by [pairsThrough],
+// and the entries that start or end at an added node have to be enumerated again, instead of every pair of nodes
+void CircuitGraphEvaluator::updatePathTable(const std::unordered_map<Node<ExpressionId>, std::size_t>& removed, const std::vector<Node<ExpressionId>>& added)
+{
+	std::unordered_set<std::pair<Node<ExpressionId>, Node<ExpressionId>>> worklist;
+	for (const auto& node : std::views::keys(removed))
+	{
+		if (const auto itr = pairsThrough.find(node.index); itr != pairsThrough.end())
+		{
+			worklist.insert(itr->second.begin(), itr->second.end());
+			pairsThrough.erase(itr);
+		}
+	}
+	pathTable.eraseIf([&removed](const auto& entry) { return removed.contains(entry.first.first) || removed.contains(entry.first.second); });
+
+	const auto& compactGraph = reducedGraph.compact();
+	PathSearchWorkspace workspace;
+	for (const auto& [start, end] : worklist)
+	{
+		// the lists of [pairsThrough] may still hold entries whose end points were merged in an earlier pass
+		const auto s = compactGraph.denseId(start);
+		const auto e = compactGraph.denseId(end);
+		if (s != -1 && e != -1)
+		{
+			updatePathTableEntry(compactGraph, workspace, s, e);
+		}
+	}
+
+	// the added nodes are new end points, only the nodes they reach and the nodes that reach them can be paired with them
+	std::vector<std::vector<int>> predecessors(compactGraph.vertexCount());
+	for (int vertex = 0; vertex < compactGraph.vertexCount(); vertex++)
+	{
+		for (const auto successor : compactGraph.successors(vertex))
+		{
+			predecessors[successor].push_back(vertex);
+		}
+	}
+	for (const auto& node : added)
+	{
+		const auto vertex = compactGraph.denseId(node);
+		const auto reachable = compactGraph.reachable(vertex);
+		std::vector<bool> reaching(compactGraph.vertexCount());
+		std::vector<int> stack{ vertex };
+		reaching[vertex] = true;
+		while (!stack.empty())
+		{
+			const auto v = stack.back();
+			stack.pop_back();
+			for (const auto predecessor : predecessors[v])
+			{
+				if (!reaching[predecessor])
 				{
-					result.emplace(std::make_pair(start, end), paths);
+					reaching[predecessor] = true;
+					stack.push_back(predecessor);
 				}
 			}
 		}
+		for (int other = 0; other < compactGraph.vertexCount(); other++)
+		{
+			if (other != vertex && reachable[other])
+			{
+				updatePathTableEntry(compactGraph, workspace, vertex, other);
+			}
+			if (other != vertex && reaching[other])
+			{
+				updatePathTableEntry(compactGraph, workspace, other, vertex);
+			}
+		}
 	}
-	return result;
+	compactPathPool();
 }
 
-// Try get any direct paths (i.e., paths that have no branching and are pairwise disjoint) between two arbitrarily selected nodes.
-// Returns a map whose key is the start and end node, value is the direct paths between start(exclusive) and end(exclusive)
-template <typename T>
-std::optional<std::pair<std::pair<Node<T>, Node<T>>, std::vector<std::vector<Node<T>>>>> CircuitGraphEvaluator::anyNonBranchingParallelEdge(
-	Graph<T>& graph, 
-	const std::unordered_map<std::pair<Node<T>, Node<T>>, std::vector<std::vector<Node<T>>>>& allPaths)
+// The paths of the entries that were enumerated again are left behind in the pool, once they take up most of it the live
+// paths are copied into a new pool
+void CircuitGraphEvaluator::compactPathPool()
 {
-	for (const auto& pair : allPaths)
+	std::size_t live = 0;
+	for (const auto& paths : std::views::values(pathTable))
+	{
+		for (const auto& path : paths)
+		{
+			live += path.length;
+		}
+	}
+	if (pathPool.size() <= 2 * live + 1024)
 	{
-		std::vector<std::vector<Node<T>>> vector;
-		for (const auto& vec : pair.second)
+		return;
+	}
+	PathPool compacted;
+	std::vector<int> indices;
+	for (auto& paths : std::views::values(pathTable))
+	{
+		for (auto& path : paths)
 		{
-			// if the successor (adjacencyList[node]) is more than one, then there is a branching during the path
-			if (std::ranges::all_of(vec, [&graph](const Node<T>& node) { return graph.adjacencyList[node].size() == 1; }))
+			pathPool.copy(path, indices);
+			path = compacted.add(indices);
+		}
+	}
+	pathPool = std::move(compacted);
+}
+
+const Node<ExpressionId>& CircuitGraphEvaluator::reducedGraphNode(const int index) const
+{
+	// nodes are compared and hashed by their index only, the data of the key is irrelevant
+	return reducedGraph.adjacency().find(Node<ExpressionId>(0, index))->first;
+}
+
+// Keep only the direct paths (i.e., paths that have no branching) of [paths], returns nothing unless there are at least two of them
+// and they are pairwise disjoint
+std::vector<PathHandle> CircuitGraphEvaluator::nonBranchingPaths(const std::vector<PathHandle>& paths) const
+{
+	std::vector<PathHandle> vector;
+	for (const auto path : paths)
+	{
+		// if the successor (adjacencyList[node]) is more than one, then there is a branching during the path
+		auto branchFree = true;
+		pathPool.forEachBackward(path, [this, &branchFree](const int index)
 			{
-				vector.push_back(vec);
-			}
+				branchFree = branchFree && reducedGraph.adjacency().find(Node<ExpressionId>(0, index))->second.size() == 1;
+			});
+		if (branchFree)
+		{
+			vector.push_back(path);
 		}
-		// we consider only those who have distinct paths (i.e., the paths between [start] and [end] are disjoint)
-		if (vector.size() >= 2 && CircuitCalculator::Utils::PrefixDistinct(vector) && CircuitCalculator::Utils::PrefixDistinct(vector, true))
+	}
+	// we consider only those who have distinct paths (i.e., the paths between [start] and [end] are disjoint)
+	if (vector.size() >= 2 && CircuitCalculator::Utils::PrefixDistinct(pathPool, vector) && CircuitCalculator::Utils::PrefixDistinct(pathPool, vector, true))
+	{
+		return vector;
+	}
+	return {};
+}
+
+// Try get any direct paths (i.e., paths that have no branching and are pairwise disjoint) between two arbitrarily selected nodes.
+// Returns a map whose key is the start and end node, value is the direct paths between start(exclusive) and end(exclusive)
+std::optional<std::pair<std::pair<Node<ExpressionId>, Node<ExpressionId>>, std::vector<PathHandle>>> CircuitGraphEvaluator::anyNonBranchingParallelEdge() const
+{
+	for (const auto& pair : pathTable)
+	{
+		if (auto vector = nonBranchingPaths(pair.second); !vector.empty())
 		{
-			return std::make_pair(pair.first, vector);
+			return std::make_pair(pair.first, std::move(vector));
 		}
 	}
 	return {};
 }
 
+// Same as anyNonBranchingParallelEdge, but collects as many groups of direct paths as possible, such that no node of a group is
+// part of, or an end point of, another group. Such groups do not interfere with each other and can be merged at the same time
+std::vector<std::pair<std::pair<Node<ExpressionId>, Node<ExpressionId>>, std::vector<PathHandle>>> CircuitGraphEvaluator::allNonBranchingParallelEdges() const
+{
+	std::vector<std::pair<std::pair<Node<ExpressionId>, Node<ExpressionId>>, std::vector<PathHandle>>> groups;
+	std::unordered_set<int> merged, endPoints;
+	for (const auto& pair : pathTable)
+	{
+		auto vector = nonBranchingPaths(pair.second);
+		if (vector.empty() || merged.contains(pair.first.first.index) || merged.contains(pair.first.second.index))
+		{
+			continue;
+		}
+		auto overlaps = false;
+		for (const auto path : vector)
+		{
+			pathPool.forEachBackward(path, [&merged, &endPoints, &overlaps](const int index)
+				{
+					overlaps = overlaps || merged.contains(index) || endPoints.contains(index);
+				});
+		}
+		if (overlaps)
+		{
+			continue;
+		}
+		for (const auto path : vector)
+		{
+			pathPool.forEachBackward(path, [&merged](const int index) { merged.insert(index); });
+		}
+		endPoints.insert(pair.first.first.index);
+		endPoints.insert(pair.first.second.index);
+		groups.emplace_back(pair.first, std::move(vector));
+	}
+	return groups;
+}
+
 // This function is the key of the who algorithm
 // It iteratively reduce a graph, merge parallel edges until there is only serial paths left in the who graph.
 // There is a similar concept called Series-Parallel Graph, see https://en.wikipedia.org/wiki/Series%E2%80%93parallel_graph, the difference here
@@ -122,88 +301,211 @@ std::optional<std::pair<std::pair<Node<T>, Node<T>>, std::vector<std::vector<Nod
 //
 // To reduce a graph, we need to know which part, that is to say, is "parallel", we say path (S, T) and (S', T') are parallel if and only if
 // they have no common prefix and common suffix except the start and end node, and they're disjoint
-bool CircuitGraphEvaluator::reduce()
+//
+// In batch mode, every group of parallel paths that does not overlap with the others is merged in the same pass, so the number of passes
+// follows the nesting depth of the circuit rather than the number of groups
+bool CircuitGraphEvaluator::reduce(const bool batch)
 {
-	const auto allPaths = allNonTrivialPathsOfReducedGraph();
-	if (const auto nonBranchingParallelEdges = anyNonBranchingParallelEdge(reducedGraph, allPaths); nonBranchingParallelEdges.has_value())
+	std::vector<std::pair<std::pair<Node<ExpressionId>, Node<ExpressionId>>, std::vector<PathHandle>>> groups;
+	if (batch)
 	{
-		std::vector<std::string> serialImpedance;
-		const auto& [endPoints, parallelEdges] = nonBranchingParallelEdges.value();
-		auto allNodeInParallelEdges = std::accumulate(parallelEdges.begin(), parallelEdges.end(), std::unordered_set<Node<std::string>>(),
-			[](std::unordered_set<Node<std::string>> accumulator, const std::vector<Node<std::string>>& set)
-			{
-				std::ranges::copy(set, std::inserter(accumulator, accumulator.begin()));
-				return accumulator;
-			});
-		// we have guaranteed that all paths in [nonBranchingParallelEdges] is branch-free, which assures that we can simply treat them
+		groups = allNonBranchingParallelEdges();
+	}
+	else if (auto nonBranchingParallelEdges = anyNonBranchingParallelEdge(); nonBranchingParallelEdges.has_value())
+	{
+		groups.push_back(std::move(nonBranchingParallelEdges.value()));
+	}
+	if (groups.empty())
+	{
+		return false;
+	}
+
+	// the group that every node of the parallel paths belongs to, and the node who will replace each group
+	std::unordered_map<Node<ExpressionId>, std::size_t> groupOf;
+	std::vector<Node<ExpressionId>> reducedNodes;
+	auto nextIndex = std::ranges::max(reducedGraph.vertices()).index + 1;
+	for (const auto& [endPoints, parallelEdges] : groups)
+	{
+		for (const auto path : parallelEdges)
+		{
+			pathPool.forEachBackward(path, [this, &groupOf, &reducedNodes](const int index) { groupOf.emplace(reducedGraphNode(index), reducedNodes.size()); });
+		}
+		std::vector<ExpressionId> serialImpedance;
+		// we have guaranteed that all paths in [parallelEdges] is branch-free, which assures that we can simply treat them
 		// as serial circuits and add up the impedance of units through the path.
-		std::ranges::transform(parallelEdges, std::back_inserter(serialImpedance), [this](const std::vector<Node<std::string>>& set) { return generateSerialEquation(set); });
-		// create the node who will replace the nodes in the [allNodeInParallelEdges], it's impedance will be calculated on-the-fly by
-		// [generateParallelEquation(serialImpedance)] instead of deferred to the time that the graph has been fully reduced
-		Node reducedNode(generateParallelEquation(serialImpedance), std::ranges::max(reducedGraph.vertices()).index + 1);
+		std::ranges::transform(parallelEdges, std::back_inserter(serialImpedance), [this](const PathHandle path) { return generateSerialEquation(path); });
+		// create the node who will replace the nodes of the group, it carries the id of its equation in [expressions] rather than
+		// the text, so the sub equations are never copied however deep they are nested
+		reducedNodes.emplace_back(generateParallelEquation(serialImpedance), nextIndex++);
+	}
 
-		// preserve the original topological structure of the graph except those who is the part of the parallel paths, since they are
-		// meant to be merged, we don't need them in the new graph
-		Graph<std::string> newGraph;
-		for (const auto& [start, successors] : reducedGraph.adjacencyList)
+	// preserve the original topological structure of the graph except those who is the part of the parallel paths, since they are
+	// meant to be merged, we don't need them in the new graph, and relay all the incoming edges that points to any node of parallel
+	// path to the new node of its group
+	Graph<ExpressionId> newGraph;
+	for (const auto& [start, successors] : reducedGraph.adjacency())
+	{
+		if (groupOf.contains(start))
+		{
+			continue;
+		}
+		for (const auto& successor : successors)
 		{
-			if (!allNodeInParallelEdges.contains(start))
+			if (const auto itr = groupOf.find(successor); itr != groupOf.end())
 			{
-				for (const auto& successor : successors | std::views::filter([&allNodeInParallelEdges](const Node<std::string>& node) { return !allNodeInParallelEdges.contains(node); }))
-				{
-					newGraph.addEdge(start, successor);
-				}
+				newGraph.addEdge(start, reducedNodes[itr->second]);
+			}
+			else
+			{
+				newGraph.addEdge(start, successor);
 			}
 		}
+	}
 
-		// relay all the incoming edges that points to any node of parallel path to the new node we've just created
-		auto oldVertices = reducedGraph.vertices();
-		// ReSharper disable once CppTooWideScopeInitStatement
-		auto incomingNodes = oldVertices
-			| std::views::filter([&allNodeInParallelEdges](const Node<std::string>& node) { return !allNodeInParallelEdges.contains(node); })
-			| std::views::filter([this, &allNodeInParallelEdges](const Node<std::string>& node)
-				{
-					auto& successors = reducedGraph.adjacencyList[node];
-					std::unordered_set<Node<std::string>> dummy;
-					std::ranges::set_intersection(successors, allNodeInParallelEdges, std::inserter(dummy, dummy.begin()));
-					return dummy.size() > 0;
-				});
+	// only incoming edges needs to be considered, since we're using a direct graph, and the previous code ensures that no branch
+	// will occur in the parallel paths, so the only outgoing edges will be those who pointing to the end of the path.
+	for (std::size_t group = 0; group < groups.size(); group++)
+	{
+		newGraph.addEdge(reducedNodes[group], groups[group].first.second);
+	}
+	reducedGraph = newGraph;
+	updatePathTable(groupOf, reducedNodes);
+	return true;
+}
 
-		for (const auto& incomingNode : incomingNodes)
-		{
-			newGraph.addEdge(incomingNode, reducedNode);
-		}
+ExpressionId CircuitGraphEvaluator::generateSerialEquation(const std::vector<Node<ExpressionId>>& set)
+{
+	std::vector<ExpressionId> terms;
+	terms.reserve(set.size());
+	std::ranges::transform(set, std::back_inserter(terms), [](const Node<ExpressionId>& node) { return node.data; });
+	return expressions.series(terms);
+}
+
+ExpressionId CircuitGraphEvaluator::generateSerialEquation(const PathHandle path)
+{
+	std::vector<ExpressionId> terms;
+	terms.reserve(path.length);
+	pathPool.forEachBackward(path, [this, &terms](const int index) { terms.push_back(reducedGraphNode(index).data); });
+	// the pool walks a path from its end
+	std::ranges::reverse(terms);
+	return expressions.series(terms);
+}
 
-		// only incoming edges needs to be considered, since we're using a direct graph, and the previous code ensures that no branch
-		// will occur in the parallel paths, so the only outgoing edges will be those who pointing to the end of the path.
-		newGraph.addEdge(reducedNode, endPoints.second);
-		reducedGraph = newGraph;
-		return true;
+ExpressionId CircuitGraphEvaluator::generateParallelEquation(const std::vector<ExpressionId>& vec)
+{
+	return expressions.parallel(vec);
+}
+
+std::vector<ExpressionId> CircuitGraphEvaluator::generateSerialTerms(const SeriesParallelTree& tree, const int node)
+{
+	std::vector<ExpressionId> terms;
+	if (tree.nodes[node].kind == SeriesParallelNodeKind::Series)
+	{
+		std::ranges::transform(tree.nodes[node].children, std::back_inserter(terms), [this, &tree](const int child) { return generateTreeEquation(tree, child); });
+	}
+	else
+	{
+		terms.push_back(generateTreeEquation(tree, node));
+	}
+	return terms;
+}
+
+ExpressionId CircuitGraphEvaluator::generateTreeEquation(const SeriesParallelTree& tree, const int node)
+{
+	const auto& current = tree.nodes[node];
+	if (current.kind == SeriesParallelNodeKind::Unit)
+	{
+		return unitExpression(compactGraph.index(current.unit));
+	}
+	if (current.kind == SeriesParallelNodeKind::Series)
+	{
+		return expressions.series(generateSerialTerms(tree, node));
 	}
-	return false;
+	// every branch is a series of its own, even when it consists of a single unit
+	std::vector<ExpressionId> branches;
+	for (const auto child : current.children)
+	{
+		branches.push_back(expressions.series(generateSerialTerms(tree, child)));
+	}
+	return generateParallelEquation(branches);
 }
 
-std::string CircuitGraphEvaluator::generateSerialEquation(const std::vector<Node<std::string>>& set)
+const SeriesParallelTree& CircuitGraphEvaluator::decompose()
 {
-	return CircuitCalculator::Utils::Join(set.begin(), set.end(), "+", [this](const Node<std::string>& node) { return node.data.empty() ? "" : node.index == graph.vertices().begin()->index ? node.data : node.data + "I"; });
+	if (!decomposition.has_value())
+	{
+		decomposition = SeriesParallelDecomposer(compactGraph).decompose();
+	}
+	return decomposition.value();
 }
 
-inline std::string CircuitGraphEvaluator::generateParallelEquation(const std::vector<std::string>& vec)
+ExpressionId CircuitGraphEvaluator::equation()
 {
-	auto reversed = vec | std::views::transform([](const std::string& str) { return "[1/" + str + "]"; });
-	return "{1/" + CircuitCalculator::Utils::Join(reversed.begin(), reversed.end(), " + ") + "}";
+	const auto& tree = decompose();
+	auto terms = generateSerialTerms(tree, tree.root());
+	terms.insert(terms.begin(), unitExpression(compactGraph.index(tree.power)));
+	return expressions.series(terms);
 }
 
-std::string CircuitGraphEvaluator::generateEquation()
+std::string CircuitGraphEvaluator::generateEquation(const EquationFormat format)
 {
+	std::string equation;
+	EquationEmitter(expressions, format).emit(this->equation(), equation);
+	return equation;
+}
+
+void CircuitGraphEvaluator::generateEquation(std::ostream& out, const EquationFormat format)
+{
+	EquationEmitter(expressions, format).emit(equation(), out);
+}
+
+std::string CircuitGraphEvaluator::generateEquationByReduction(const bool batch)
+{
+	translateGraph();
 	// reduce the graph until it reaches a fixed point
-	do {} while (reduce());
-	std::vector<Node<std::string>> vec;
+	do {} while (reduce(batch));
+	std::vector<Node<ExpressionId>> vec;
 	std::ranges::copy(reducedGraph.vertices(), std::back_inserter(vec));
-	return generateSerialEquation(vec);
+	std::string equation;
+	EquationEmitter(expressions).emit(generateSerialEquation(vec), equation);
+	return equation;
 }
 
-CircuitGraphEvaluator::CircuitGraphEvaluator(const Graph<std::shared_ptr<CircuitScriptGraphNode>>& graph): graph(graph)
+const EvaluationTape& CircuitGraphEvaluator::compile()
 {
-	translateGraph();
-}
\ No newline at end of file
+	if (!tape.has_value())
+	{
+		tape.emplace(compactGraph, decompose(), components);
+		unitValues = EvaluationTape::unitValues(compactGraph, components);
+	}
+	return tape.value();
+}
+
+CircuitEvaluationResult CircuitGraphEvaluator::evaluate()
+{
+	const auto* power = components.powerSupply();
+	const auto impedance = compile().execute(unitValues, power->frequencyInHz, registers);
+	return { impedance, power->voltageInVolt / impedance };
+}
+
+FrequencySweepResult CircuitGraphEvaluator::sweep(const std::span<const double> frequenciesInHz)
+{
+	// compile() fills [unitValues], so it must run before the span of them is taken, which the order of the arguments does
+	// not guarantee
+	const auto& compiled = compile();
+	return FrequencySweepEvaluator(compiled, unitValues).sweep(frequenciesInHz);
+}
+
+CircuitEvaluationSession CircuitGraphEvaluator::session()
+{
+	return { compactGraph, decompose(), components };
+}
+
+CircuitGraphEvaluator::CircuitGraphEvaluator(const Graph<CircuitScriptGraphNodeKind>& graph, CircuitComponentTable components)
+	: graph(graph), compactGraph(graph), components(std::move(components))
+{
+	if (this->components.powerSupply() == nullptr)
+	{
+		throw NoPowerSupplyFoundException();
+	}
+}
@@ -17,34 +17,124 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
-#include <memory>
+#include <complex>
+#include <ostream>
 #include <optional>
 
+#include "CircuitComponentTable.h"
+#include "CircuitEvaluationSession.h"
 #include "CircuitScriptGraphNode.h"
+#include "CompactGraph.h"
+#include "EquationEmitter.h"
+#include "EvaluationTape.h"
+#include "ExpressionDag.h"
+#include "FlatHashMap.h"
+#include "FrequencySweep.h"
 #include "Graph.h"
+#include "PathPool.h"
+#include "SeriesParallelDecomposition.h"
 
 class CircuitGraphEvaluator
 {
-	Graph<std::shared_ptr<CircuitScriptGraphNode>> graph;
+	Graph<CircuitScriptGraphNodeKind> graph;
 
-	Graph<std::string> reducedGraph;
+	CompactGraph<CircuitScriptGraphNodeKind> compactGraph;
 
-	std::string impedance(const std::shared_ptr<CircuitScriptGraphNode>&);
+	CircuitComponentTable components;
 
-	std::string generateSerialEquation(const std::vector<Node<std::string>>& set);
+	// the equations generated so far, the nodes of [reducedGraph] and the tree equations refer to it by id
+	ExpressionDag expressions;
 
-	static std::string generateParallelEquation(const std::vector<std::string>& vec);
+	// the graph that [generateEquationByReduction] merges the parallel paths of, the members down to [pairsThrough] only
+	// serve that cross-check
+	Graph<ExpressionId> reducedGraph;
+
+	// the vertices of the paths in [pathTable], as the indices of the nodes of [reducedGraph]
+	PathPool pathPool;
+
+	// all the non trivial paths of [reducedGraph] by their start and end node, kept up to date across the passes of [reduce]
+	FlatHashMap<std::pair<Node<ExpressionId>, Node<ExpressionId>>, std::vector<PathHandle>> pathTable;
+
+	// the entries of [pathTable] that have a path going through the node of each index, it may also list entries that no longer do
+	FlatHashMap<int, std::vector<std::pair<Node<ExpressionId>, Node<ExpressionId>>>> pairsThrough;
+
+	std::optional<SeriesParallelTree> decomposition;
+
+	std::optional<EvaluationTape> tape;
+
+	std::vector<double> unitValues;
+
+	// the register file of the tape, reused across evaluations
+	std::vector<std::complex<double>> registers;
+
+	// the impedance of the unit whose node has [index]
+	std::string impedance(int index);
+
+	// the leaf expression of the unit whose node has [index]
+	ExpressionId unitExpression(int index);
+
+	// the node of [reducedGraph] whose index is [index]
+	const Node<ExpressionId>& reducedGraphNode(int index) const;
+
+	ExpressionId generateSerialEquation(const std::vector<Node<ExpressionId>>& set);
+
+	ExpressionId generateSerialEquation(PathHandle path);
+
+	ExpressionId generateParallelEquation(const std::vector<ExpressionId>& vec);
 
 	void translateGraph();
 
-	std::unordered_map<std::pair<Node<std::string>, Node<std::string>>, std::vector<std::vector<Node<std::string>>>> allNonTrivialPathsOfReducedGraph();
+	void updatePathTableEntry(const CompactGraph<ExpressionId>& compactGraph, PathSearchWorkspace& workspace, int start, int end);
+
+	void allNonTrivialPathsOfReducedGraph();
 
-	template <typename T>
-	static std::optional<std::pair<std::pair<Node<T>, Node<T>>, std::vector<std::vector<Node<T>>>>> anyNonBranchingParallelEdge(Graph<T>& graph, const std::unordered_map<std::pair<Node<T>, Node<T>>, std::vector<std::vector<Node<T>>>>& allPaths);
+	void updatePathTable(const std::unordered_map<Node<ExpressionId>, std::size_t>& removed, const std::vector<Node<ExpressionId>>& added);
 
-	bool reduce();
+	void compactPathPool();
+
+	std::vector<PathHandle> nonBranchingPaths(const std::vector<PathHandle>& paths) const;
+
+	std::optional<std::pair<std::pair<Node<ExpressionId>, Node<ExpressionId>>, std::vector<PathHandle>>> anyNonBranchingParallelEdge() const;
+
+	std::vector<std::pair<std::pair<Node<ExpressionId>, Node<ExpressionId>>, std::vector<PathHandle>>> allNonBranchingParallelEdges() const;
+
+	bool reduce(bool batch);
+
+	std::vector<ExpressionId> generateSerialTerms(const SeriesParallelTree& tree, int node);
+
+	ExpressionId generateTreeEquation(const SeriesParallelTree& tree, int node);
+
+	ExpressionId equation();
 public:
-	explicit CircuitGraphEvaluator(const Graph<std::shared_ptr<CircuitScriptGraphNode>>& graph);
+	CircuitGraphEvaluator(const Graph<CircuitScriptGraphNodeKind>& graph, CircuitComponentTable components);
+
+	// Decompose the circuit into its series and parallel parts, throws NonSeriesParallelCircuitException if the circuit
+	// contains a part that cannot be decomposed, e.g., a bridge
+	const SeriesParallelTree& decompose();
+
+	// Compile the decomposition into a tape, which can then be executed with any unit values and frequency, see
+	// EvaluationTape::unitValues for the layout of the values
+	const EvaluationTape& compile();
+
+	// Generate the equation from the series-parallel decomposition of the circuit
+	std::string generateEquation(EquationFormat format = EquationFormat::Text);
+
+	// Same as generateEquation(format), but writes the equation to [out] as it goes instead of building it in memory
+	void generateEquation(std::ostream& out, EquationFormat format = EquationFormat::Text);
+
+	// Generate the equation by merging the parallel paths of the graph until a fixed point is reached. It is kept only to
+	// cross-check the decomposition, generateEquation does not go through it, so the path table, the path pool and the
+	// batched passes below only make the cross-check faster. In [batch] mode every pass merges all the groups of parallel
+	// paths that do not overlap, otherwise only one of them
+	std::string generateEquationByReduction(bool batch = true);
+
+	// Compute the equivalent impedance and the source current numerically from the series-parallel decomposition, without
+	// formatting any string
+	CircuitEvaluationResult evaluate();
+
+	// Evaluate the equivalent impedance at every frequency of the grid, the frequency of the power supply is ignored
+	FrequencySweepResult sweep(std::span<const double> frequenciesInHz);
 
-	std::string generateEquation();
+	// Start a session in which the values of the units can be changed one at a time
+	CircuitEvaluationSession session();
 };
\ No newline at end of file
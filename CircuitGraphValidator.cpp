@@ -1,42 +1,131 @@
 ﻿#include "CircuitGraphValidator.h"
 
 #include <algorithm>
-#include <numeric>
+#include <atomic>
+#include <span>
 
 #include "CircuitExceptions.h"
+#include "CompactGraph.h"
 #include "ElementaryCircuits.h"
+#include "StrongComponents.h"
 
-void CircuitGraphValidator::validate()
+void CircuitGraphValidator::validateReachability(const CompactGraph<CircuitScriptGraphNodeKind>& compactGraph)
 {
-	if (graph.vertices().begin()->data->kind != CircuitScriptGraphNodeKind::Power)
+	// Check if there is a power supply wired into the circuit
+	const auto power = compactGraph.denseId(components.powerSupplyIndex());
+	if (components.powerSupply() == nullptr || power == -1)
 	{
-		
+		throw NoPowerSupplyFoundException();
 	}
 	// Check if all units are reachable from the power supply
-	auto allVertices = graph.vertices();
-	auto reachableFromPower = graph.reachable(*graph.vertices().begin());
-	std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>> diff;
-	std::ranges::set_difference(allVertices, reachableFromPower, std::inserter(diff, diff.begin()));
+	const auto reachableFromPower = compactGraph.reachable(power);
+	std::set<Node<CircuitScriptGraphNodeKind>> diff;
+	for (int vertex = 0; vertex < compactGraph.vertexCount(); vertex++)
+	{
+		if (!reachableFromPower[vertex])
+		{
+			diff.insert(compactGraph.node(vertex));
+		}
+	}
 	if (!diff.empty())
 	{
 		throw UnreachableUnitException(diff);
 	}
+}
+
+void CircuitGraphValidator::validateCoverage(const CompactGraph<CircuitScriptGraphNodeKind>& compactGraph, const std::vector<bool>& covered)
+{
 	// Check if all units are in the circuits
-	ElementaryCircuits ec(graph);
-	auto elementaryCircuits = ec.elementaryCircuits();
-	auto allCircuits = std::accumulate(elementaryCircuits.begin(), elementaryCircuits.end(), std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>>(),
-		[](std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>> accumulator, const std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>>& current)
+	std::set<Node<CircuitScriptGraphNodeKind>> circuitDiff;
+	for (int vertex = 0; vertex < compactGraph.vertexCount(); vertex++)
+	{
+		if (!covered[vertex])
 		{
-			for (auto& node : current)
+			circuitDiff.insert(compactGraph.node(vertex));
+		}
+	}
+	if (!circuitDiff.empty())
+	{
+		throw UnitPartiallyConnectedException(circuitDiff);
+	}
+}
+
+void CircuitGraphValidator::validate()
+{
+	const CompactGraph compactGraph(graph);
+	validateReachability(compactGraph);
+	// A unit lies on some elementary circuit exactly when it shares a strong component with another unit, or when it is
+	// wired to itself, so the coverage is known without enumerating a single circuit
+	std::vector<bool> covered(compactGraph.vertexCount());
+	for (const auto& component : StrongComponents(compactGraph).denseStrongComponents())
+	{
+		if (component.size() > 1)
+		{
+			for (const auto vertex : component)
 			{
-				accumulator.insert(node);
+				covered[vertex] = true;
 			}
-			return accumulator;
+		}
+	}
+	for (int vertex = 0; vertex < compactGraph.vertexCount(); vertex++)
+	{
+		if (std::ranges::find(compactGraph.successors(vertex), vertex) != compactGraph.successors(vertex).end())
+		{
+			covered[vertex] = true;
+		}
+	}
+	validateCoverage(compactGraph, covered);
+}
+
+void CircuitGraphValidator::validateByEnumeration()
+{
+	const CompactGraph compactGraph(graph);
+	validateReachability(compactGraph);
+	// only the union of the circuits matters, so the enumeration stops as soon as every unit has been seen on some circuit
+	std::vector<bool> covered(compactGraph.vertexCount());
+	auto uncovered = compactGraph.vertexCount();
+	ElementaryCircuits(compactGraph).forEachCircuit([&covered, &uncovered](const std::span<const int> circuit)
+		{
+			for (const auto vertex : circuit)
+			{
+				if (!covered[vertex])
+				{
+					covered[vertex] = true;
+					uncovered--;
+				}
+			}
+			return uncovered > 0;
 		});
-	std::set<Node<std::shared_ptr<CircuitScriptGraphNode>>> circuitDiff;
-	std::ranges::set_difference(allVertices, allCircuits, std::inserter(circuitDiff, circuitDiff.begin()));
-	if (!circuitDiff.empty())
+	validateCoverage(compactGraph, covered);
+}
+
+void CircuitGraphValidator::validateByEnumeration(WorkStealingThreadPool& pool)
+{
+	const CompactGraph compactGraph(graph);
+	validateReachability(compactGraph);
+	std::vector<std::atomic<bool>> marks(compactGraph.vertexCount());
+	std::atomic<int> uncovered = compactGraph.vertexCount();
+	ElementaryCircuits(compactGraph).forEachCircuit(pool, [&marks, &uncovered](const std::span<const int> circuit)
+		{
+			for (const auto vertex : circuit)
+			{
+				if (!marks[vertex].exchange(true, std::memory_order_relaxed))
+				{
+					uncovered.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
+			return uncovered.load(std::memory_order_relaxed) > 0;
+		});
+	std::vector<bool> covered(marks.size());
+	for (std::size_t vertex = 0; vertex < marks.size(); vertex++)
 	{
-		throw UnitPartiallyConnectedException(circuitDiff);
+		covered[vertex] = marks[vertex].load();
 	}
+	validateCoverage(compactGraph, covered);
+}
+
+std::vector<std::set<Node<CircuitScriptGraphNodeKind>>> CircuitGraphValidator::circuits() const
+{
+	const CompactGraph compactGraph(graph);
+	return ElementaryCircuits(compactGraph).elementaryCircuits();
 }
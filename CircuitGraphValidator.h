@@ -17,18 +17,41 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
-#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 
+#include "CircuitComponentTable.h"
 #include "CircuitScriptGraphNode.h"
+#include "CompactGraph.h"
 #include "Graph.h"
+#include "WorkStealingThreadPool.h"
 
 class CircuitGraphValidator
 {
-	Graph<std::shared_ptr<CircuitScriptGraphNode>> graph;
+	Graph<CircuitScriptGraphNodeKind> graph;
+	CircuitComponentTable components;
+
+	void validateReachability(const CompactGraph<CircuitScriptGraphNodeKind>& compactGraph);
+
+	// [covered] tells for each dense id whether the unit lies on some elementary circuit
+	static void validateCoverage(const CompactGraph<CircuitScriptGraphNodeKind>& compactGraph, const std::vector<bool>& covered);
 public:
-	explicit CircuitGraphValidator(const Graph<std::shared_ptr<CircuitScriptGraphNode>>& graph) : graph(graph)
+	CircuitGraphValidator(const Graph<CircuitScriptGraphNodeKind>& graph, CircuitComponentTable components)
+		: graph(graph), components(std::move(components))
 	{
 	}
 
+	// Check the power supply, the reachability of every unit and that every unit lies on some circuit, in O(V+E)
 	void validate();
+
+	// Same as validate(), but decides the coverage by enumerating the elementary circuits until every unit has been seen on one
+	// of them, kept as a cross-check of the linear mode since the enumeration can take exponential time
+	void validateByEnumeration();
+
+	// Same as validateByEnumeration(), but enumerates the circuits on the workers of [pool]
+	void validateByEnumeration(WorkStealingThreadPool& pool);
+
+	// All the elementary circuits of the graph, for diagnostics that need to report the loops themselves
+	std::vector<std::set<Node<CircuitScriptGraphNodeKind>>> circuits() const;
 };
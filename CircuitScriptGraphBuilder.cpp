@@ -0,0 +1,281 @@
+﻿#include "CircuitScriptGraphBuilder.h"
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <string>
+
+#include "ParseException.h"
+
+std::size_t CircuitScriptGraphBuilder::statementOf(const CircuitScriptStatementBuffer& statements, const std::size_t declaration)
+{
+	// the connections before the declaration are those with at most [declaration] declarations before them
+	const auto connections = std::ranges::upper_bound(statements.connections, declaration, {}, &CircuitScriptConnection::declarations);
+	return declaration + (connections - statements.connections.begin());
+}
+
+Graph<CircuitScriptGraphNodeKind> CircuitScriptGraphBuilder::build(std::vector<CircuitScriptStatementPiece> pieces)
+{
+	if (const auto incomplete = std::ranges::find_if(pieces, [](const CircuitScriptStatementPiece& piece) { return !piece.statements->complete; }); incomplete != pieces.end())
+	{
+		pieces.erase(incomplete + 1, pieces.end());
+	}
+	// only the names that cross pieces go through the maps, there are none with a single piece
+	const auto shared = pieces.size() > 1;
+	const auto partitionCount = pool == nullptr ? std::size_t{ 1 } : pool->size() * 4;
+	// the partitions take the high bits of the hash, the maps of the partitions the low ones
+	const auto partitionOf = [partitionCount](const std::size_t hash) { return (hash >> 24) % partitionCount; };
+	std::vector<PieceState> states(pieces.size());
+
+	// find the first declaration of every name of each piece, and sort the names that may cross pieces into the partitions
+	forEach(pieces.size(), [&](const std::size_t piece)
+		{
+			const auto& [statements, names] = pieces[piece];
+			auto& state = states[piece];
+			state.firstDeclarations.assign(names->size(), NoDeclaration);
+			for (std::size_t declaration = 0; declaration < statements->declarations.size(); declaration++)
+			{
+				const auto& [identifier, component] = statements->declarations[declaration];
+				if (state.firstDeclarations[identifier] == NoDeclaration)
+				{
+					state.firstDeclarations[identifier] = declaration;
+				}
+				if (std::holds_alternative<PowerComponent>(component))
+				{
+					state.powers.push_back(declaration);
+				}
+			}
+			if (statements->error)
+			{
+				state.errorStatement = statements->declarations.size() + statements->connections.size();
+				state.error = statements->error;
+			}
+			state.imports.assign(names->size(), -1);
+			if (!shared)
+			{
+				return;
+			}
+			state.hashes.resize(names->size());
+			state.declaredNames.resize(partitionCount);
+			state.importedNames.resize(partitionCount);
+			for (std::size_t id = 0; id < names->size(); id++)
+			{
+				if (state.firstDeclarations[id] != NoDeclaration)
+				{
+					state.hashes[id] = FlatHash<std::string_view>{}(names->name(static_cast<int>(id)));
+					state.declaredNames[partitionOf(state.hashes[id])].push_back(static_cast<int>(id));
+				}
+			}
+			std::vector<bool> imported(names->size());
+			for (const auto& [from, to, declarations] : statements->connections)
+			{
+				for (const auto identifier : { from, to })
+				{
+					if (const auto first = state.firstDeclarations[identifier]; (first == NoDeclaration || first >= declarations) && !imported[identifier])
+					{
+						imported[identifier] = true;
+						if (first == NoDeclaration)
+						{
+							state.hashes[identifier] = FlatHash<std::string_view>{}(names->name(identifier));
+						}
+						state.importedNames[partitionOf(state.hashes[identifier])].push_back(identifier);
+					}
+				}
+			}
+		});
+
+	// the first power unit is node 0, and the other units are numbered from 1 in order, so every piece starts where the
+	// units of the pieces before it end
+	std::optional<std::pair<std::size_t, std::size_t>> power;
+	std::vector<int> firstNodes(pieces.size());
+	auto nodeCount = 1;
+	for (std::size_t piece = 0; piece < pieces.size(); piece++)
+	{
+		auto& state = states[piece];
+		firstNodes[piece] = nodeCount;
+		nodeCount += static_cast<int>(pieces[piece].statements->declarations.size() - state.powers.size());
+		for (const auto declaration : state.powers)
+		{
+			if (!power.has_value())
+			{
+				power.emplace(piece, declaration);
+			}
+			else if (const auto statement = statementOf(*pieces[piece].statements, declaration); statement < state.errorStatement)
+			{
+				state.errorStatement = statement;
+				state.error = std::make_exception_ptr(ParseException("ParseError: Only one power unit can be defined"));
+			}
+		}
+	}
+	std::vector<std::optional<Node<CircuitScriptGraphNodeKind>>> nodes(nodeCount);
+	forEach(pieces.size(), [&](const std::size_t piece)
+		{
+			const auto& declarations = pieces[piece].statements->declarations;
+			auto& state = states[piece];
+			state.nodes.resize(declarations.size());
+			auto next = firstNodes[piece];
+			for (std::size_t declaration = 0; declaration < declarations.size(); declaration++)
+			{
+				if (!std::holds_alternative<PowerComponent>(declarations[declaration].component))
+				{
+					state.nodes[declaration] = next;
+					nodes[next].emplace(ComponentKind(declarations[declaration].component), next);
+					next++;
+				}
+				else if (power == std::make_pair(piece, declaration))
+				{
+					state.nodes[declaration] = 0;
+					nodes[0].emplace(CircuitScriptGraphNodeKind::Power, 0);
+				}
+			}
+			state.locals.assign(state.firstDeclarations.size(), -1);
+			for (std::size_t id = 0; id < state.firstDeclarations.size(); id++)
+			{
+				if (state.firstDeclarations[id] != NoDeclaration)
+				{
+					state.locals[id] = state.nodes[state.firstDeclarations[id]];
+				}
+			}
+		});
+
+	// every partition keeps the first declaration of each of its names, the pieces are looked at in order, so a name that an
+	// earlier piece declares already resolves to that declaration in the later ones. Then the imported names are looked up,
+	// they resolve only to the declarations of the earlier pieces
+	if (shared)
+	{
+		forEach(partitionCount, [&](const std::size_t partition)
+			{
+				FlatHashMap<HashedName, Symbol, HashedNameHash> table;
+				for (std::size_t piece = 0; piece < pieces.size(); piece++)
+				{
+					const auto& names = *pieces[piece].names;
+					auto& state = states[piece];
+					for (const auto identifier : state.declaredNames[partition])
+					{
+						const HashedName name{ names.name(identifier), state.hashes[identifier] };
+						if (const auto itr = table.find(name); itr != table.end())
+						{
+							state.locals[identifier] = itr->second.node;
+						}
+						else
+						{
+							table.insert_or_assign(name, Symbol{ state.locals[identifier], piece });
+						}
+					}
+				}
+				for (std::size_t piece = 0; piece < pieces.size(); piece++)
+				{
+					const auto& names = *pieces[piece].names;
+					auto& state = states[piece];
+					for (const auto identifier : state.importedNames[partition])
+					{
+						if (const auto itr = table.find(HashedName{ names.name(identifier), state.hashes[identifier] }); itr != table.end() && itr->second.piece < piece)
+						{
+							state.imports[identifier] = itr->second.node;
+						}
+					}
+				}
+			});
+	}
+
+	// a name used by a connection must be declared by a statement before it
+	forEach(pieces.size(), [&](const std::size_t piece)
+		{
+			const auto& [statements, names] = pieces[piece];
+			auto& state = states[piece];
+			const auto resolve = [&state](const int identifier, const std::size_t declarations)
+			{
+				// NoDeclaration is never below [declarations]
+				return state.firstDeclarations[identifier] < declarations ? state.locals[identifier] : state.imports[identifier];
+			};
+			state.edges.reserve(statements->connections.size());
+			for (std::size_t connection = 0; connection < statements->connections.size(); connection++)
+			{
+				const auto& [from, to, declarations] = statements->connections[connection];
+				if (declarations + connection >= state.errorStatement)
+				{
+					break;
+				}
+				const auto fromNode = resolve(from, declarations);
+				const auto toNode = fromNode == -1 ? -1 : resolve(to, declarations);
+				if (toNode == -1)
+				{
+					state.errorStatement = declarations + connection;
+					state.error = std::make_exception_ptr(ParseException("ParseError: Undefined unit used: " + std::string(names->name(fromNode == -1 ? from : to))));
+					break;
+				}
+				state.edges.emplace_back(fromNode, toNode);
+			}
+		});
+
+	for (const auto& state : states)
+	{
+		if (state.error)
+		{
+			std::rethrow_exception(state.error);
+		}
+	}
+	for (std::size_t piece = 0; piece < pieces.size(); piece++)
+	{
+		const auto& [statements, names] = pieces[piece];
+		for (std::size_t declaration = 0; declaration < statements->declarations.size(); declaration++)
+		{
+			const auto& [identifier, component] = statements->declarations[declaration];
+			componentTable.add(states[piece].nodes[declaration], component, std::string(names->name(identifier)));
+		}
+	}
+	return buildGraph(nodes, states);
+}
+
+Graph<CircuitScriptGraphNodeKind> CircuitScriptGraphBuilder::buildGraph(const std::vector<std::optional<Node<CircuitScriptGraphNodeKind>>>& nodes, const std::vector<PieceState>& states) const
+{
+	// the successors of every node are gathered into one array, sorted by their source
+	std::vector<int> offsets(nodes.size() + 1);
+	// the nodes that are connected at all, Graph::addEdge gives an entry to both ends of an edge
+	std::vector<bool> connected(nodes.size());
+	for (const auto& state : states)
+	{
+		for (const auto& [from, to] : state.edges)
+		{
+			offsets[from + 1]++;
+			connected[from] = connected[to] = true;
+		}
+	}
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<int> targets(offsets.back());
+	auto positions = offsets;
+	for (const auto& state : states)
+	{
+		for (const auto& [from, to] : state.edges)
+		{
+			targets[positions[from]++] = to;
+		}
+	}
+
+	std::vector<std::set<Node<CircuitScriptGraphNodeKind>>> successors(nodes.size());
+	const auto rangeCount = pool == nullptr ? std::size_t{ 1 } : pool->size() * 4;
+	forEach(rangeCount, [&](const std::size_t range)
+		{
+			for (auto node = nodes.size() * range / rangeCount; node < nodes.size() * (range + 1) / rangeCount; node++)
+			{
+				const auto begin = targets.begin() + offsets[node];
+				const auto end = targets.begin() + offsets[node + 1];
+				std::sort(begin, end);
+				for (auto target = begin; target != end; ++target)
+				{
+					successors[node].emplace_hint(successors[node].end(), *nodes[*target]);
+				}
+			}
+		});
+
+	std::unordered_map<Node<CircuitScriptGraphNodeKind>, std::set<Node<CircuitScriptGraphNodeKind>>> adjacencyList;
+	adjacencyList.reserve(std::ranges::count(connected, true));
+	for (std::size_t node = 0; node < nodes.size(); node++)
+	{
+		if (connected[node])
+		{
+			adjacencyList.emplace(*nodes[node], std::move(successors[node]));
+		}
+	}
+	return Graph(std::move(adjacencyList));
+}
@@ -0,0 +1,171 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/CircuitScriptGraphBuilder.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CircuitComponentTable.h"
+#include "CircuitScriptGraphNode.h"
+#include "CircuitScriptIdentifierTable.h"
+#include "FlatHashMap.h"
+#include "Graph.h"
+#include "WorkStealingThreadPool.h"
+
+// A unit declared by a script, [identifier] is the id of its name in the identifier table of the lexer that scanned it
+struct CircuitScriptDeclaration
+{
+	int identifier;
+	CircuitComponent component;
+};
+
+// A connect statement, [declarations] is the number of declarations of the same buffer that precede it
+struct CircuitScriptConnection
+{
+	int from;
+	int to;
+	std::size_t declarations;
+};
+
+// The statements parsed from a script, or from a piece of it, before the names are resolved. [error] is the error that
+// stopped the parsing, if any, the statements before it are kept, so that an error of a later statement is only reported
+// after those of the statements before it, just as if the script was checked statement by statement
+struct CircuitScriptStatementBuffer
+{
+	std::vector<CircuitScriptDeclaration> declarations;
+	std::vector<CircuitScriptConnection> connections;
+	std::exception_ptr error;
+	// whether the parser got to the end of the text, it stops early at a token that cannot begin a statement
+	bool complete = false;
+};
+
+// The statements of a piece of a script and the table their identifier ids refer to
+struct CircuitScriptStatementPiece
+{
+	const CircuitScriptStatementBuffer* statements;
+	const CircuitScriptIdentifierTable* names;
+};
+
+// Resolves the names of the statements of the consecutive pieces of a script and builds the graph of the script from them
+// The nodes are numbered in the order of the declarations, the power supply is 0 and the other units start at 1. Within a
+// piece the names are resolved through vectors indexed by their identifier ids, only the names that a piece declares and
+// the names it uses before, or without, declaring them are hashed into maps shared by all the pieces, and a script in a
+// single piece never hashes a name. With a thread pool, every step but the last one, which moves the successor sets into
+// the adjacency list, works on the pieces, or on the partitions of the names, concurrently
+class CircuitScriptGraphBuilder
+{
+	// the first declaration of a name in the whole script
+	struct Symbol
+	{
+		int node;
+		std::size_t piece;
+	};
+
+	// a name with its hash, which is computed once and used both to choose the partition and by the map of the partition
+	struct HashedName
+	{
+		std::string_view name;
+		std::size_t hash;
+
+		bool operator==(const HashedName& another) const
+		{
+			return name == another.name;
+		}
+	};
+
+	struct HashedNameHash
+	{
+		std::size_t operator()(const HashedName& name) const
+		{
+			return name.hash;
+		}
+	};
+
+	// what is worked out about a piece on the way, the vectors indexed by id are indexed by the identifier ids of the piece
+	struct PieceState
+	{
+		// the first declaration of every name in the piece, indexed by id, NoDeclaration for the names it does not declare
+		std::vector<std::size_t> firstDeclarations;
+		// the node that every name declared by the piece resolves to, indexed by id, which is that of an earlier piece if
+		// the name is declared there too
+		std::vector<int> locals;
+		// the node that every name used before its declaration in the piece, if any, resolves to, indexed by id, -1 if no
+		// earlier piece declares it
+		std::vector<int> imports;
+		// the node index of every declaration
+		std::vector<int> nodes;
+		// the declarations of the power units
+		std::vector<std::size_t> powers;
+		// the hash of every name that is declared or imported, indexed by id, only with more than one piece
+		std::vector<std::size_t> hashes;
+		// the ids of the names declared by the piece, and of those it imports, that fall into each partition
+		std::vector<std::vector<int>> declaredNames;
+		std::vector<std::vector<int>> importedNames;
+		std::vector<std::pair<int, int>> edges;
+		// the statement of the piece at which the piece fails and why, see [statementOf]
+		std::size_t errorStatement = static_cast<std::size_t>(-1);
+		std::exception_ptr error;
+	};
+
+	static constexpr std::size_t NoDeclaration = static_cast<std::size_t>(-1);
+
+	WorkStealingThreadPool* pool;
+	CircuitComponentTable componentTable;
+
+	// Call [fn] with 0, 1, ..., [count] - 1, on the pool if there is one
+	template <typename Fn>
+	void forEach(const std::size_t count, const Fn& fn) const
+	{
+		if (pool == nullptr)
+		{
+			for (std::size_t i = 0; i < count; i++)
+			{
+				fn(i);
+			}
+			return;
+		}
+		for (std::size_t i = 0; i < count; i++)
+		{
+			pool->submit([&fn, i] { fn(i); });
+		}
+		pool->wait();
+	}
+
+	// The position of the [declaration]th declaration among all the statements of [statements]
+	static std::size_t statementOf(const CircuitScriptStatementBuffer& statements, std::size_t declaration);
+
+	Graph<CircuitScriptGraphNodeKind> buildGraph(const std::vector<std::optional<Node<CircuitScriptGraphNodeKind>>>& nodes, const std::vector<PieceState>& states) const;
+public:
+	// Everything is done on the calling thread if [pool] is nullptr
+	explicit CircuitScriptGraphBuilder(WorkStealingThreadPool* pool = nullptr) : pool(pool)
+	{
+	}
+
+	// Resolve the names of [pieces] and build the graph, throws the error that checking the pieces statement by statement
+	// in order would run into first. The pieces after one that is not complete are ignored, like the rest of its text
+	Graph<CircuitScriptGraphNodeKind> build(std::vector<CircuitScriptStatementPiece> pieces);
+
+	const CircuitComponentTable& components() const
+	{
+		return componentTable;
+	}
+};
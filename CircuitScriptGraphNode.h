@@ -17,8 +17,9 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
-#include <string>
 
+// The kind of a unit, which is the payload of the nodes of the circuit graphs, the values and the names of the units are
+// kept by CircuitComponentTable, keyed by the index of their nodes
 enum class CircuitScriptGraphNodeKind
 {
 	Power,
@@ -27,93 +28,3 @@ enum class CircuitScriptGraphNodeKind
 	Ground,
 	Inductor
 };
-
-class CircuitScriptGraphNode
-{
-public:
-	CircuitScriptGraphNodeKind kind;
-	std::string tag;
-
-	CircuitScriptGraphNode(const CircuitScriptGraphNodeKind kind, std::string tag) : kind(kind), tag(std::move(tag))
-	{
-	}
-
-	CircuitScriptGraphNode(const CircuitScriptGraphNode& other) = default;
-
-	CircuitScriptGraphNode(CircuitScriptGraphNode&& other) noexcept : kind(other.kind), tag(std::move(other.tag))
-	{
-	}
-
-	CircuitScriptGraphNode& operator=(const CircuitScriptGraphNode& other)
-	{
-		if (this == &other)
-			return *this;
-		kind = other.kind;
-		tag = other.tag;
-		return *this;
-	}
-
-	CircuitScriptGraphNode& operator=(CircuitScriptGraphNode&& other) noexcept
-	{
-		if (this == &other)
-			return *this;
-		kind = other.kind;
-		tag = other.tag;
-		return *this;
-	}
-
-	virtual ~CircuitScriptGraphNode() = default;
-};
-
-class CircuitScriptPowerGraphNode final : public CircuitScriptGraphNode
-{
-public:
-	double voltageInVolt;
-	double frequencyInHz;
-
-	CircuitScriptPowerGraphNode(const double voltageInVolt, const double frequencyInHz, const std::string& t)
-		: CircuitScriptGraphNode(CircuitScriptGraphNodeKind::Power, t), voltageInVolt(voltageInVolt), frequencyInHz(frequencyInHz)
-	{
-	}
-};
-
-class CircuitScriptResistorGraphNode final : public CircuitScriptGraphNode
-{
-public:
-	double resistanceInO;
-
-	explicit CircuitScriptResistorGraphNode(const double resistanceInO, const std::string& t)
-		: CircuitScriptGraphNode(CircuitScriptGraphNodeKind::Resistor, t), resistanceInO(resistanceInO)
-	{
-	}
-};
-
-class CircuitScriptCapacitorGraphNode final : public CircuitScriptGraphNode
-{
-public:
-	double capacitanceInF;
-
-	explicit CircuitScriptCapacitorGraphNode(const double capacitanceInF, const std::string& t)
-		: CircuitScriptGraphNode(CircuitScriptGraphNodeKind::Capacitor, t), capacitanceInF(capacitanceInF)
-	{
-	}
-};
-
-class CircuitScriptInductorGraphNode final : public CircuitScriptGraphNode
-{
-public:
-	double inductanceInH;
-
-	explicit CircuitScriptInductorGraphNode(const double inductanceInH, const std::string& t)
-		: CircuitScriptGraphNode(CircuitScriptGraphNodeKind::Inductor, t), inductanceInH(inductanceInH)
-	{
-	}
-};
-
-class CircuitScriptGroundGraphNode final : public CircuitScriptGraphNode
-{
-public:
-	explicit CircuitScriptGroundGraphNode(const std::string& t) : CircuitScriptGraphNode(CircuitScriptGraphNodeKind::Ground, t)
-	{
-	}
-};
\ No newline at end of file
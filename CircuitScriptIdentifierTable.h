@@ -0,0 +1,99 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/CircuitScriptIdentifierTable.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "FlatHashMap.h"
+
+// Interns the identifiers of a script, every distinct name gets a dense id, 0, 1, 2, ..., in the order it is first seen, so
+// that the parser can keep its symbols in a vector indexed by the id rather than in a map keyed by the name
+// The bytes of every name are stored once, in blocks that are never moved or freed while the table lives, the views handed
+// out by [name], and the keys of the lookup map, point into them
+class CircuitScriptIdentifierTable
+{
+	static constexpr std::size_t BlockSize = 64 * 1024;
+
+	std::vector<std::unique_ptr<char[]>> blocks;
+	// the number of bytes used of the last block
+	std::size_t used = BlockSize;
+	std::vector<std::string_view> names;
+	FlatHashMap<std::string_view, int> ids;
+
+	// Copy [name] into the arena
+	std::string_view store(const std::string_view name)
+	{
+		if (name.size() > BlockSize)
+		{
+			// a name that does not fit in a block gets one of its own, inserted before the last block so that the
+			// free space of that one is not lost
+			auto& block = *blocks.insert(blocks.empty() ? blocks.end() : blocks.end() - 1, std::make_unique<char[]>(name.size()));
+			std::memcpy(block.get(), name.data(), name.size());
+			return { block.get(), name.size() };
+		}
+		if (BlockSize - used < name.size())
+		{
+			blocks.push_back(std::make_unique<char[]>(BlockSize));
+			used = 0;
+		}
+		const auto data = blocks.back().get() + used;
+		std::memcpy(data, name.data(), name.size());
+		used += name.size();
+		return { data, name.size() };
+	}
+public:
+	CircuitScriptIdentifierTable() = default;
+
+	CircuitScriptIdentifierTable(const CircuitScriptIdentifierTable&) = delete;
+
+	CircuitScriptIdentifierTable& operator=(const CircuitScriptIdentifierTable&) = delete;
+
+	CircuitScriptIdentifierTable(CircuitScriptIdentifierTable&&) noexcept = default;
+
+	CircuitScriptIdentifierTable& operator=(CircuitScriptIdentifierTable&&) noexcept = default;
+
+	// The id of [name], which is added to the table if it is not in it yet
+	int intern(const std::string_view name)
+	{
+		if (const auto itr = ids.find(name); itr != ids.end())
+		{
+			return itr->second;
+		}
+		const auto id = static_cast<int>(names.size());
+		const auto stored = store(name);
+		names.push_back(stored);
+		ids.insert_or_assign(stored, id);
+		return id;
+	}
+
+	// The name of [id], valid as long as the table
+	std::string_view name(const int id) const
+	{
+		return names[id];
+	}
+
+	// The number of distinct names, every id is below it
+	std::size_t size() const
+	{
+		return names.size();
+	}
+};
@@ -1,104 +1,278 @@
 ﻿#include "CircuitScriptLexer.h"
 
-#include <sstream>
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 
-CircuitScriptTokenInfo CircuitScriptLexer::parseNumber()
+#include "ParseException.h"
+
+namespace
 {
-	std::stringstream ss;
-	while (index < static_cast<int>(str.size()) && isNumber(str.at(index)))
+	constexpr std::uint64_t Ones = 0x0101010101010101;
+	constexpr std::uint64_t Low = 0x7F7F7F7F7F7F7F7F;
+	constexpr std::uint64_t High = 0x8080808080808080;
+
+	// The high bit of every byte of [word] that equals [c]
+	constexpr std::uint64_t BytesEqual(const std::uint64_t word, const unsigned char c)
 	{
-		ss << str.at(index++);
+		const auto t = word ^ Ones * c;
+		return ~(((t & Low) + Low) | t | Low);
 	}
-	if (index < static_cast<int>(str.size()) && str.at(index) == '.')
+
+	// The high bit of every byte of [word] in [lo, hi], both of them below 0x80
+	// Each byte is compared on its own 7 bits, the sums never carry into the next byte, so unlike the usual zero byte tricks
+	// the bits of all the bytes are exact
+	constexpr std::uint64_t BytesBetween(const std::uint64_t word, const unsigned char lo, const unsigned char hi)
 	{
-		index++;
-		ss << '.';
-		while (index < static_cast<int>(str.size()) && isNumber(str.at(index)))
+		const auto low = word & Low;
+		return (Ones * (128 + hi) - low) & ~word & (low + Ones * (128 - lo)) & High;
+	}
+
+	constexpr auto Blanks = [](const std::uint64_t word)
+	{
+		return BytesEqual(word, ' ') | BytesEqual(word, '\t') | BytesEqual(word, '\n') | BytesEqual(word, '\r');
+	};
+
+	constexpr auto Digits = [](const std::uint64_t word)
+	{
+		return BytesBetween(word, '0', '9');
+	};
+
+	// setting the 0x20 bit turns the upper case letters into lower case ones and no other byte into a letter
+	constexpr auto Alphanumerics = [](const std::uint64_t word)
+	{
+		return BytesBetween(word, '0', '9') | BytesBetween(word | Ones * 0x20, 'a', 'z');
+	};
+
+	// The scale of the SI multiplier [c], or 0 if it is not one
+	constexpr double Multiplier(const char c)
+	{
+		switch (c)
+		{
+		case 'f': return 1E-15;
+		case 'p': return 1E-12;
+		case 'n': return 1E-9;
+		case 'u': return 1E-6;
+		case 'm': return 1E-3;
+		case 'k': return 1E3;
+		case 'M': return 1E6;
+		case 'G': return 1E9;
+		default: return 0;
+		}
+	}
+
+	constexpr bool IsDigit(const char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	constexpr bool IsAlphanumeric(const char c)
+	{
+		return IsDigit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+	}
+
+	// The position of the first byte of [text] at or after [from] that is not matched by [matches], which takes eight
+	// bytes at a time and returns the high bit of every byte it matches. The last word is padded with zeros, which no
+	// matcher accepts
+	template <typename Matches>
+	std::size_t SkipWhile(const std::string_view text, std::size_t from, const Matches& matches)
+	{
+		for (;; from += 8)
 		{
-			ss << str.at(index++);
+			std::uint64_t word = 0;
+			std::memcpy(&word, text.data() + from, std::min<std::size_t>(8, text.size() - from));
+			if (const auto mismatches = ~matches(word) & High; mismatches != 0)
+			{
+				return from + (std::endian::native == std::endian::little ? std::countr_zero(mismatches) : std::countl_zero(mismatches)) / 8;
+			}
 		}
 	}
-	return { CircuitScriptTokenKind::Number, ss.str() };
 }
 
-CircuitScriptTokenInfo CircuitScriptLexer::parseKeywordOrIdentifier()
+// The end of the number that starts at [index] of [text], i.e., digits[.digits][(e|E)[+|-]digits][multiplier]. An exponent needs
+// at least one digit, and a multiplier must not be followed by a letter or a digit, otherwise they are not part of the number.
+// [truncated] is set if the number may go on beyond the end of [text]
+std::size_t CircuitScriptLexer::scanNumber(const std::string_view text, std::size_t index, bool& truncated)
 {
-	std::stringstream ss;
-	while (index < static_cast<int>(str.size()) && (std::isalpha(str.at(index)) || std::isdigit(str.at(index))))
+	const auto at = [&text, &truncated](const std::size_t i)
+	{
+		truncated = truncated || i >= text.size();
+		return i < text.size() ? text[i] : '\0';
+	};
+	index = SkipWhile(text, index, Digits);
+	if (at(index) == '.')
 	{
-		ss << str.at(index++);
+		index = SkipWhile(text, index + 1, Digits);
 	}
+	if (const auto e = at(index); e == 'e' || e == 'E')
+	{
+		const auto sign = at(index + 1);
+		const auto digits = sign == '+' || sign == '-' ? index + 2 : index + 1;
+		if (IsDigit(at(digits)))
+		{
+			index = SkipWhile(text, digits, Digits);
+		}
+	}
+	if (Multiplier(at(index)) != 0 && !IsAlphanumeric(at(index + 1)))
+	{
+		index++;
+	}
+	return index;
+}
 
-	auto s = ss.str();
-
-	if (keywordDictionary.contains(s))
+double CircuitScriptLexer::numberValue(const std::string_view text)
+{
+	const auto multiplier = text.empty() ? 0 : Multiplier(text.back());
+	const auto digits = multiplier == 0 ? text : text.substr(0, text.size() - 1);
+	double value;
+	if (const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value); error == std::errc::result_out_of_range)
+	{
+		throw ParseException("ParseError: Number out of range: " + std::string(text));
+	}
+	else if (error != std::errc() || end != digits.data() + digits.size())
 	{
-		return keywordDictionary.at(s);
+		throw ParseException("ParseError: Malformed number: " + std::string(text));
 	}
-	return { CircuitScriptTokenKind::Identifier, s };
+	return multiplier == 0 ? value : value * multiplier;
 }
 
-bool CircuitScriptLexer::isNumber(const char n)
+bool CircuitScriptLexer::hasMultiplier(const std::string_view text)
 {
-	return n >= '0' && n <= '9';
+	return !text.empty() && Multiplier(text.back()) != 0;
 }
 
-CircuitScriptLexer::CircuitScriptLexer(std::string str) : str(std::move(str))
+CircuitScriptTokenKind CircuitScriptLexer::keywordOrIdentifier(const std::string_view word)
 {
-	keywordDictionary.emplace("connect", CircuitScriptTokenInfo(CircuitScriptTokenKind::KeywordConnect, "connect"));
-	keywordDictionary.emplace("power", CircuitScriptTokenInfo(CircuitScriptTokenKind::KeywordPower, "power"));
-	keywordDictionary.emplace("resistor", CircuitScriptTokenInfo(CircuitScriptTokenKind::KeywordResistor, "resistor"));
-	keywordDictionary.emplace("capacitor", CircuitScriptTokenInfo(CircuitScriptTokenKind::KeywordCapacitor, "capacitor"));
-	keywordDictionary.emplace("ground", CircuitScriptTokenInfo(CircuitScriptTokenKind::KeywordGround, "ground"));
-	keywordDictionary.emplace("inductor", CircuitScriptTokenInfo(CircuitScriptTokenKind::KeywordInductor, "inductor"));
+	switch (word.size())
+	{
+	case 5:
+		return word == "power" ? CircuitScriptTokenKind::KeywordPower : CircuitScriptTokenKind::Identifier;
+	case 6:
+		return word == "ground" ? CircuitScriptTokenKind::KeywordGround : CircuitScriptTokenKind::Identifier;
+	case 7:
+		return word == "connect" ? CircuitScriptTokenKind::KeywordConnect : CircuitScriptTokenKind::Identifier;
+	case 8:
+		return word == "resistor" ? CircuitScriptTokenKind::KeywordResistor : word == "inductor" ? CircuitScriptTokenKind::KeywordInductor : CircuitScriptTokenKind::Identifier;
+	case 9:
+		return word == "capacitor" ? CircuitScriptTokenKind::KeywordCapacitor : CircuitScriptTokenKind::Identifier;
+	default:
+		return CircuitScriptTokenKind::Identifier;
+	}
 }
 
-std::optional<CircuitScriptTokenInfo> CircuitScriptLexer::nextToken()
+// Scan the current window from [index], returns the number of bytes scanned. Unless the chunk is the [last] one, a number or
+// an identifier that runs up to the end of the window may go on in the next chunk, it is left unscanned
+std::size_t CircuitScriptLexer::tokenize(std::size_t index, const bool last)
 {
-	auto skipBlanks = [this]
+	const std::string_view text(windows[current]);
+	for (index = SkipWhile(text, index, Blanks); index < text.size(); index = SkipWhile(text, index, Blanks))
 	{
-		while (index < static_cast<int>(str.size()) && (str.at(index) == '\r' || str.at(index) == '\n' || str.at(index) == '\t' || str.at(index) == ' '))
+		const auto start = index;
+		switch (text[index])
+		{
+		case '=':
+			tokens.push(CircuitScriptTokenKind::Equal, index++, 1);
+			break;
+		case '(':
+			tokens.push(CircuitScriptTokenKind::LeftParen, index++, 1);
+			break;
+		case ')':
+			tokens.push(CircuitScriptTokenKind::RightParen, index++, 1);
+			break;
+		case ',':
+			tokens.push(CircuitScriptTokenKind::Comma, index++, 1);
+			break;
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
 		{
-			index++;
+			auto truncated = false;
+			index = scanNumber(text, index, truncated);
+			if (truncated && !last)
+			{
+				return start;
+			}
+			tokens.push(CircuitScriptTokenKind::Number, start, index - start);
+			break;
 		}
-	};
-	if (index >= static_cast<int>(str.size()))
+		default:
+		{
+			index = SkipWhile(text, index, Alphanumerics);
+			if (index == start)
+			{
+				error = std::make_exception_ptr(ParseException("ParseError: Unexpected character '" + std::string(1, text[index]) + "'"));
+				return text.size();
+			}
+			if (index == text.size() && !last)
+			{
+				return start;
+			}
+			const auto word = text.substr(start, index - start);
+			const auto kind = keywordOrIdentifier(word);
+			tokens.push(kind, start, index - start, kind == CircuitScriptTokenKind::Identifier ? identifierTable.intern(word) : -1);
+			break;
+		}
+		}
+	}
+	return text.size();
+}
+
+// Move on to the other window, which starts with the unscanned rest of the current one, and fill it with chunks until it has
+// at least one token, returns false at the end of the script
+bool CircuitScriptLexer::refill()
+{
+	if (error)
 	{
-		return {};
+		std::rethrow_exception(error);
+	}
+	if (exhausted)
+	{
+		return false;
 	}
+	auto& window = windows[1 - current];
+	window.assign(windows[current], consumed);
+	current = 1 - current;
+	consumed = 0;
+	tokens.clear();
+	next = 0;
+	do
+	{
+		const auto chunk = source->read();
+		exhausted = chunk.empty();
+		window.append(chunk);
+		consumed = tokenize(consumed, exhausted);
+	}
+	while (tokens.size() == 0 && !exhausted && !error);
+	if (tokens.size() == 0 && error)
+	{
+		std::rethrow_exception(error);
+	}
+	return tokens.size() != 0;
+}
 
-	switch (str.at(index))
+CircuitScriptLexer::CircuitScriptLexer(std::string str) : CircuitScriptLexer(std::make_unique<CircuitScriptStringSource>(std::move(str)))
+{
+}
+
+CircuitScriptLexer::CircuitScriptLexer(std::unique_ptr<CircuitScriptSource> source) : source(std::move(source))
+{
+}
+
+std::optional<CircuitScriptTokenInfo> CircuitScriptLexer::nextToken()
+{
+	if (next == tokens.size() && !refill())
 	{
-	case '=':
-		index++;
-		return CircuitScriptTokenInfo(CircuitScriptTokenKind::Equal, "=");
-	case '(':
-		index++;
-		return CircuitScriptTokenInfo(CircuitScriptTokenKind::LeftParen, "(");
-	case ')':
-		index++;
-		return CircuitScriptTokenInfo(CircuitScriptTokenKind::RightParen, ")");
-	case ',':
-		index++;
-		return CircuitScriptTokenInfo(CircuitScriptTokenKind::Comma, ",");
-	case ' ': 
-	case '\n':
-	case '\t':
-	case '\r':
-		skipBlanks();
-		return nextToken();
-	case '0':
-	case '1':
-	case '2':
-	case '3':
-	case '4':
-	case '5':
-	case '6':
-	case '7':
-	case '8':
-	case '9':
-		return parseNumber();
-	default:
-		return parseKeywordOrIdentifier();
+		return {};
 	}
+	const auto token = next++;
+	return CircuitScriptTokenInfo(tokens.kinds[token], text(token), tokens.identifiers[token]);
 }
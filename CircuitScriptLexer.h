@@ -17,22 +17,78 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
+#include <array>
+#include <exception>
+#include <memory>
 #include <optional>
-#include <unordered_map>
+#include <string>
 
+#include "CircuitScriptIdentifierTable.h"
+#include "CircuitScriptSource.h"
 #include "CircuitScriptTokenInfo.h"
 
+// Reads the script from a CircuitScriptSource chunk by chunk, scans each chunk once into a CircuitScriptTokenBuffer, and then
+// hands the tokens out one by one
+// The identifiers are interned as they are scanned, a token of an identifier carries its id in [identifiers]
+// The numbers may be written in scientific notation and end with an SI multiplier, e.g., 1e-9, 4.7k or 470u
+// The blanks, identifiers and numbers are skipped a machine word at a time, and the keywords are told apart by a switch on
+// their length rather than looked up in a map. A token cut by the end of a chunk is carried over to the window of the next
+// chunk, and the window of the previous chunk is kept alive, so the text of a token handed out by nextToken stays valid until
+// the tokens of the chunk after the next one are being handed out. Only two windows of about one chunk each are ever held
 class CircuitScriptLexer
 {
-	std::unordered_map<std::string, CircuitScriptTokenInfo> keywordDictionary;
-	const std::string str;
-	int index = 0;
+	std::unique_ptr<CircuitScriptSource> source;
+	std::array<std::string, 2> windows;
+	// the window whose tokens are in [tokens]
+	int current = 0;
+	// the number of bytes of the current window that have been scanned, the rest is the beginning of a token that
+	// continues in the next chunk
+	std::size_t consumed = 0;
+	bool exhausted = false;
+	// the error at the end of [tokens], e.g., a character that cannot begin a token, it is raised by nextToken once the
+	// tokens before it have been handed out, so that the parser reports it at the statement it is in
+	std::exception_ptr error;
+	CircuitScriptTokenBuffer tokens;
+	// the next token to be handed out by nextToken
+	std::size_t next = 0;
+	CircuitScriptIdentifierTable identifierTable;
 
-	CircuitScriptTokenInfo parseNumber();
-	CircuitScriptTokenInfo parseKeywordOrIdentifier();
-	static bool isNumber(char n);
+	std::size_t tokenize(std::size_t from, bool last);
+
+	bool refill();
+
+	static std::size_t scanNumber(std::string_view text, std::size_t index, bool& truncated);
+
+	static CircuitScriptTokenKind keywordOrIdentifier(std::string_view word);
 public:
 	explicit CircuitScriptLexer(std::string str);
 
+	explicit CircuitScriptLexer(std::unique_ptr<CircuitScriptSource> source);
+
+	// The tokens of the current window
+	const CircuitScriptTokenBuffer& tokenBuffer() const
+	{
+		return tokens;
+	}
+
+	// The text of the [token]th token of the current window
+	std::string_view text(const std::size_t token) const
+	{
+		return std::string_view(windows[current]).substr(tokens.offsets[token], tokens.lengths[token]);
+	}
+
 	std::optional<CircuitScriptTokenInfo> nextToken();
+
+	// The identifiers scanned so far
+	const CircuitScriptIdentifierTable& identifiers() const
+	{
+		return identifierTable;
+	}
+
+	// The value of the text of a Number token, with its SI multiplier (f, p, n, u, m, k, M or G) applied, throws
+	// ParseException if it does not fit in a double
+	static double numberValue(std::string_view text);
+
+	// Whether the text of a Number token ends with an SI multiplier
+	static bool hasMultiplier(std::string_view text);
 };
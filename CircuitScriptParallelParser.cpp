@@ -0,0 +1,71 @@
+﻿#include "CircuitScriptParallelParser.h"
+
+#include <algorithm>
+#include <optional>
+
+#include "CircuitScriptLexer.h"
+#include "CircuitScriptParser.h"
+#include "CircuitScriptSource.h"
+#include "ParseException.h"
+
+CircuitScriptParallelParser::CircuitScriptParallelParser(const std::string_view script, WorkStealingThreadPool& pool, const std::size_t pieceCount)
+	: script(script), pool(pool), pieceCount(pieceCount == 0 ? std::max<std::size_t>(pool.size(), 1) * 4 : pieceCount), builder(&pool)
+{
+}
+
+std::vector<std::string_view> CircuitScriptParallelParser::split(const std::string_view script, const std::size_t pieceCount)
+{
+	constexpr std::string_view blanks = " \t\r\n";
+	std::vector<std::string_view> pieces;
+	const auto size = std::max<std::size_t>(script.size() / std::max<std::size_t>(pieceCount, 1), 1);
+	std::size_t begin = 0;
+	while (pieces.size() + 1 < pieceCount)
+	{
+		const auto close = script.find(')', std::min(begin + size, script.size()));
+		if (close == std::string_view::npos || script.find_first_not_of(blanks, close + 1) == std::string_view::npos)
+		{
+			break;
+		}
+		pieces.push_back(script.substr(begin, close + 1 - begin));
+		begin = close + 1;
+	}
+	pieces.push_back(script.substr(begin));
+	return pieces;
+}
+
+Graph<CircuitScriptGraphNodeKind> CircuitScriptParallelParser::parse()
+{
+	const auto pieces = split(script, pieceCount);
+	std::vector<std::optional<CircuitScriptParser>> parsers(pieces.size());
+	std::vector<const CircuitScriptStatementBuffer*> statements(pieces.size());
+	// the statements of the pieces whose parser could not be constructed, they only hold the error
+	std::vector<CircuitScriptStatementBuffer> failures(pieces.size());
+	for (std::size_t piece = 0; piece < pieces.size(); piece++)
+	{
+		pool.submit([&parsers, &statements, &failures, &pieces, piece]
+			{
+				// the errors of the lexer are kept by the parser at the statement they are in, only a piece without any token
+				// throws here, which split never produces unless the whole script is blank. Whatever a task throws is kept
+				// as the error of the first statement of its piece, so that the builder reports the earliest error of the
+				// script in statement order rather than that of whichever task fails first
+				try
+				{
+					parsers[piece].emplace(CircuitScriptLexer(std::make_unique<CircuitScriptViewSource>(pieces[piece])));
+					statements[piece] = &parsers[piece]->parseStatements();
+				}
+				catch (const ParseException&)
+				{
+					failures[piece].error = std::current_exception();
+					statements[piece] = &failures[piece];
+				}
+			});
+	}
+	pool.wait();
+	const CircuitScriptIdentifierTable noNames;
+	std::vector<CircuitScriptStatementPiece> statementPieces;
+	for (std::size_t piece = 0; piece < pieces.size(); piece++)
+	{
+		statementPieces.push_back({ statements[piece], parsers[piece].has_value() ? &parsers[piece]->identifiers() : &noNames });
+	}
+	return builder.build(std::move(statementPieces));
+}
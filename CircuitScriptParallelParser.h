@@ -0,0 +1,59 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/CircuitScriptParallelParser.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "CircuitComponentTable.h"
+#include "CircuitScriptGraphBuilder.h"
+#include "CircuitScriptGraphNode.h"
+#include "Graph.h"
+#include "WorkStealingThreadPool.h"
+
+// Parses a script in two phases, the script is split into pieces at statement boundaries, the pieces are lexed and parsed
+// into statement buffers concurrently, each with a CircuitScriptParser of its own, and then the buffers are merged in
+// the order of the script by a CircuitScriptGraphBuilder, which resolves the names and builds the graph at once
+// The graph, the component table and the errors are the same as those of CircuitScriptParser on the whole script
+// The pieces are views of the buffer of the caller, e.g., a string or a mapped file, which is not copied as a whole, the
+// lexer of each piece only copies the chunk it is working on into its windows, so a piece holds a copy of about two chunks
+// at a time
+class CircuitScriptParallelParser
+{
+	std::string_view script;
+	WorkStealingThreadPool& pool;
+	std::size_t pieceCount;
+	CircuitScriptGraphBuilder builder;
+public:
+	// [pieceCount] is the number of pieces the script is split into at most, 0 for four per worker of [pool]. The text of
+	// [script] must stay alive until [parse] returns
+	CircuitScriptParallelParser(std::string_view script, WorkStealingThreadPool& pool, std::size_t pieceCount = 0);
+
+	Graph<CircuitScriptGraphNodeKind> parse();
+
+	// The units declared by the script, keyed by the index of their nodes in the graph returned by [parse]
+	const CircuitComponentTable& components() const
+	{
+		return builder.components();
+	}
+
+	// Split [script] into at most [pieceCount] pieces of about the same size, every piece ends right after a ')', which only
+	// ever closes a statement, and has something else than blanks in it
+	static std::vector<std::string_view> split(std::string_view script, std::size_t pieceCount);
+};
@@ -4,7 +4,7 @@
 
 std::optional<CircuitScriptTokenInfo> CircuitScriptParser::eatToken(const CircuitScriptTokenKind kind)
 {
-	if (lookahead.tokenKind == kind)
+	if (peek().tokenKind == kind)
 	{
 		return eatToken();
 	}
@@ -13,16 +13,33 @@ std::optional<CircuitScriptTokenInfo> CircuitScriptParser::eatToken(const Circui
 
 std::optional<CircuitScriptTokenInfo> CircuitScriptParser::eatToken()
 {
-	if (const auto optional = lexer.nextToken(); optional.has_value())
+	auto old = peek();
+	try
 	{
-		auto old = lookahead;
-		lookahead = optional.value();
+		if (const auto optional = lexer.nextToken(); optional.has_value())
+		{
+			lookahead = optional.value();
+			return old;
+		}
+	}
+	catch (const ParseException&)
+	{
+		lookaheadError = std::current_exception();
 		return old;
 	}
 	hasNextToken = false;
 	return {};
 }
 
+const CircuitScriptTokenInfo& CircuitScriptParser::peek() const
+{
+	if (lookaheadError)
+	{
+		std::rethrow_exception(lookaheadError);
+	}
+	return lookahead;
+}
+
 void CircuitScriptParser::program()
 {
 	declOrConnList();
@@ -30,7 +47,7 @@ void CircuitScriptParser::program()
 
 void CircuitScriptParser::declOrConnList()
 {
-	while (hasNextToken && lookahead.tokenKind == CircuitScriptTokenKind::Identifier || lookahead.tokenKind == CircuitScriptTokenKind::KeywordConnect)
+	while (hasNextToken && peek().tokenKind == CircuitScriptTokenKind::Identifier || peek().tokenKind == CircuitScriptTokenKind::KeywordConnect)
 	{
 		declOrConn(); 
 	}
@@ -38,7 +55,7 @@ void CircuitScriptParser::declOrConnList()
 
 void CircuitScriptParser::declOrConn()
 {
-	switch (lookahead.tokenKind)
+	switch (peek().tokenKind)
 	{
 	case CircuitScriptTokenKind::Identifier:
 		decl();
@@ -62,18 +79,19 @@ void CircuitScriptParser::declOrConn()
 
 void CircuitScriptParser::decl()
 {
-	const auto identifier = eatToken(CircuitScriptTokenKind::Identifier);
+	const auto id = eatToken(CircuitScriptTokenKind::Identifier)->identifier;
 	eatToken(CircuitScriptTokenKind::Equal);
 	const auto unitToken = unit();
 	eatToken(CircuitScriptTokenKind::LeftParen);
-	const auto parameters = optParam();
+	// the capacitance is in microfarads and the inductance in millihenries, everything else is in the base unit
+	const auto parameters = optParam(unitToken.tokenKind == CircuitScriptTokenKind::KeywordCapacitor ? 1E-6 : unitToken.tokenKind == CircuitScriptTokenKind::KeywordInductor ? 1E-3 : 1);
 	eatToken(CircuitScriptTokenKind::RightParen);
 	switch (unitToken.tokenKind)
 	{
 	case CircuitScriptTokenKind::KeywordCapacitor:
 		if (parameters.size() == 1)
 		{
-			symbolTable.emplace(identifier->text, Node<std::shared_ptr<CircuitScriptGraphNode>>(std::make_shared<CircuitScriptCapacitorGraphNode>(parameters[0], identifier->text), nodeIndex++));
+			statements.declarations.push_back({ id, CapacitorComponent{ parameters[0] } });
 		}
 		else
 		{
@@ -83,7 +101,7 @@ void CircuitScriptParser::decl()
 	case CircuitScriptTokenKind::KeywordInductor:
 		if (parameters.size() == 1)
 		{
-			symbolTable.emplace(identifier->text, Node<std::shared_ptr<CircuitScriptGraphNode>>(std::make_shared<CircuitScriptInductorGraphNode>(parameters[0], identifier->text), nodeIndex++));
+			statements.declarations.push_back({ id, InductorComponent{ parameters[0] } });
 		}
 		else
 		{
@@ -91,13 +109,10 @@ void CircuitScriptParser::decl()
 		}
 		break;
 	case CircuitScriptTokenKind::KeywordPower:
+		// a second power unit is rejected by CircuitScriptGraphBuilder, which sees the declarations of the whole script
 		if (parameters.size() == 2)
 		{
-			if (std::ranges::find_if(symbolTable, [](const std::pair<std::string, Node<std::shared_ptr<CircuitScriptGraphNode>>>& pair) { return pair.second.data->kind == CircuitScriptGraphNodeKind::Power; }) != symbolTable.end())
-			{
-				throw ParseException("ParseError: Only one power unit can be defined");
-			}
-			symbolTable.emplace(identifier->text, Node<std::shared_ptr<CircuitScriptGraphNode>>(std::make_shared<CircuitScriptPowerGraphNode>(parameters[0], parameters[1], identifier->text), 0));
+			statements.declarations.push_back({ id, PowerComponent{ parameters[0], parameters[1] } });
 		}
 		else
 		{
@@ -107,7 +122,7 @@ void CircuitScriptParser::decl()
 	case CircuitScriptTokenKind::KeywordResistor:
 		if (parameters.size() == 1)
 		{
-			symbolTable.emplace(identifier->text, Node<std::shared_ptr<CircuitScriptGraphNode>>(std::make_shared<CircuitScriptResistorGraphNode>(parameters[0], identifier->text), nodeIndex++));
+			statements.declarations.push_back({ id, ResistorComponent{ parameters[0] } });
 		}
 		else
 		{
@@ -117,7 +132,7 @@ void CircuitScriptParser::decl()
 	case CircuitScriptTokenKind::KeywordGround:
 		if (parameters.empty())
 		{
-			symbolTable.emplace(identifier->text, Node<std::shared_ptr<CircuitScriptGraphNode>>(std::make_shared<CircuitScriptGroundGraphNode>(identifier->text), nodeIndex++));
+			statements.declarations.push_back({ id, GroundComponent{} });
 		}
 		else
 		{
@@ -139,76 +154,96 @@ void CircuitScriptParser::conn()
 {
 	eatToken(CircuitScriptTokenKind::KeywordConnect);
 	eatToken(CircuitScriptTokenKind::LeftParen);
-	const auto from = eatToken(CircuitScriptTokenKind::Identifier);
+	const auto from = eatToken(CircuitScriptTokenKind::Identifier)->identifier;
 	eatToken(CircuitScriptTokenKind::Comma);
-	const auto to = eatToken(CircuitScriptTokenKind::Identifier);
+	const auto to = eatToken(CircuitScriptTokenKind::Identifier)->identifier;
 	eatToken(CircuitScriptTokenKind::RightParen);
-	if (!symbolTable.contains(from->text))
-	{
-		throw ParseException("ParseError: Undefined unit used: " + from->text);
-	}
-	if (!symbolTable.contains(to->text))
-	{
-		throw ParseException("ParseError: Undefined unit used: " + to->text);
-	}
-	graph.addEdge(symbolTable.at(from->text), symbolTable.at(to->text));
+	statements.connections.push_back({ from, to, statements.declarations.size() });
 }
 
-std::vector<double> CircuitScriptParser::optParam()
+std::vector<double> CircuitScriptParser::optParam(const double unit)
 {
-	if (lookahead.tokenKind == CircuitScriptTokenKind::Number)
+	if (peek().tokenKind == CircuitScriptTokenKind::Number)
 	{
-		return paramList();
+		return paramList(unit);
 	}
 	return {};
 }
 
-std::vector<double> CircuitScriptParser::paramList()
+std::vector<double> CircuitScriptParser::paramList(const double unit)
 {
-	const auto first = std::stod(eatToken(CircuitScriptTokenKind::Number)->text);
-	auto rest = paramListRest();
+	const auto first = number(unit);
+	auto rest = paramListRest(unit);
 	rest.insert(rest.begin(), first);
 	return rest;
 }
 
-std::vector<double> CircuitScriptParser::paramListRest()
+std::vector<double> CircuitScriptParser::paramListRest(const double unit)
 {
 	std::vector<double> params;
-	while (lookahead.tokenKind == CircuitScriptTokenKind::Comma)
+	while (peek().tokenKind == CircuitScriptTokenKind::Comma)
 	{
 		eatToken();
-		params.push_back(std::stod(eatToken(CircuitScriptTokenKind::Number)->text));
+		params.push_back(number(unit));
 	}
 	return params;
 }
 
+double CircuitScriptParser::number(const double unit)
+{
+	const auto text = eatToken(CircuitScriptTokenKind::Number)->text;
+	const auto value = CircuitScriptLexer::numberValue(text);
+	return CircuitScriptLexer::hasMultiplier(text) ? value / unit : value;
+}
+
 CircuitScriptTokenInfo CircuitScriptParser::unit()
 {
-	if (lookahead.tokenKind == CircuitScriptTokenKind::KeywordCapacitor ||
-		lookahead.tokenKind == CircuitScriptTokenKind::KeywordInductor ||
-		lookahead.tokenKind == CircuitScriptTokenKind::KeywordPower ||
-		lookahead.tokenKind == CircuitScriptTokenKind::KeywordResistor ||
-		lookahead.tokenKind == CircuitScriptTokenKind::KeywordGround)
+	if (const auto kind = peek().tokenKind; kind == CircuitScriptTokenKind::KeywordCapacitor ||
+		kind == CircuitScriptTokenKind::KeywordInductor ||
+		kind == CircuitScriptTokenKind::KeywordPower ||
+		kind == CircuitScriptTokenKind::KeywordResistor ||
+		kind == CircuitScriptTokenKind::KeywordGround)
 	{
 		return eatToken().value();
 	}
 	throw ParseException("ParseError: Token(KeywordCapacitor|KeywordInductor|KeywordPower|KeywordResistor) expected");
 }
 
-CircuitScriptParser::CircuitScriptParser(CircuitScriptLexer lexer) : nodeIndex(1), hasNextToken(true), lexer(std::move(lexer))
+CircuitScriptParser::CircuitScriptParser(CircuitScriptLexer lexer) : hasNextToken(true), lexer(std::move(lexer))
+{
+	try
+	{
+		if (const auto firstToken = this->lexer.nextToken(); firstToken.has_value())
+		{
+			lookahead = firstToken.value();
+			return;
+		}
+	}
+	catch (const ParseException&)
+	{
+		// the text cannot be lexed from its first token on, which is an error of the first statement
+		lookaheadError = std::current_exception();
+		return;
+	}
+	throw ParseException("ParseError: Expecting token");
+}
+
+const CircuitScriptStatementBuffer& CircuitScriptParser::parseStatements()
 {
-	if (const auto firstToken = this->lexer.nextToken(); firstToken.has_value())
+	try
 	{
-		lookahead = firstToken.value();
+		program();
 	}
-	else
+	catch (const ParseException&)
 	{
-		throw ParseException("ParseError: Expecting token");
+		statements.error = std::current_exception();
 	}
+	statements.complete = !hasNextToken;
+	return statements;
 }
 
-Graph<std::shared_ptr<CircuitScriptGraphNode>> CircuitScriptParser::parse()
+Graph<CircuitScriptGraphNodeKind> CircuitScriptParser::parse()
 {
-	program();
-	return graph;
+	const auto& buffer = parseStatements();
+	return builder.build({ { &buffer, &lexer.identifiers() } });
 }
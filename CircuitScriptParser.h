@@ -17,26 +17,36 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
-#include <memory>
+#include <exception>
+#include <vector>
 
+#include "CircuitComponentTable.h"
+#include "CircuitScriptGraphBuilder.h"
 #include "CircuitScriptGraphNode.h"
 #include "CircuitScriptLexer.h"
 #include "Graph.h"
 
 // The recursive descent parser of the circuit expression
+// The statements are parsed into a CircuitScriptStatementBuffer first, and the names are resolved and the graph is built from
+// it by a CircuitScriptGraphBuilder afterwards, see CircuitScriptParallelParser for why
 class CircuitScriptParser
 {
-	int nodeIndex;
 	bool hasNextToken;
 	CircuitScriptLexer lexer;
-	Graph<std::shared_ptr<CircuitScriptGraphNode>> graph;
 	CircuitScriptTokenInfo lookahead;
-	std::unordered_map<std::string, Node<std::shared_ptr<CircuitScriptGraphNode>>> symbolTable;
+	// the error the lexer ran into in place of [lookahead], it is thrown when the parser looks at the lookahead, so that
+	// it belongs to the statement the bad text is in rather than to the one whose last token was just eaten
+	std::exception_ptr lookaheadError;
+	CircuitScriptStatementBuffer statements;
+	CircuitScriptGraphBuilder builder;
 
 	std::optional<CircuitScriptTokenInfo> eatToken(CircuitScriptTokenKind kind);
 
 	std::optional<CircuitScriptTokenInfo> eatToken();
 
+	// The lookahead, throws the error of the lexer if there is one in its place
+	const CircuitScriptTokenInfo& peek() const;
+
 
 	void program();
 
@@ -48,15 +58,34 @@ class CircuitScriptParser
 
 	void conn();
 
-	std::vector<double> optParam();
+	// The parameters are read in [unit], e.g., 1E-6 for the microfarads of a capacitor, a number with an SI multiplier is in
+	// the base unit and is converted into [unit], a bare number is already in [unit]
+	std::vector<double> optParam(double unit);
+
+	std::vector<double> paramList(double unit);
 
-	std::vector<double> paramList();
+	std::vector<double> paramListRest(double unit);
 
-	std::vector<double> paramListRest();
+	double number(double unit);
 
 	CircuitScriptTokenInfo unit();
 public:
 	explicit CircuitScriptParser(CircuitScriptLexer lexer);
 
-	Graph<std::shared_ptr<CircuitScriptGraphNode>> parse();
+	Graph<CircuitScriptGraphNodeKind> parse();
+
+	// Parse the statements without resolving their names, a parse error is kept in the buffer rather than thrown
+	const CircuitScriptStatementBuffer& parseStatements();
+
+	// The names of the statements returned by [parseStatements]
+	const CircuitScriptIdentifierTable& identifiers() const
+	{
+		return lexer.identifiers();
+	}
+
+	// The units declared by the script, keyed by the index of their nodes in the graph returned by [parse]
+	const CircuitComponentTable& components() const
+	{
+		return builder.components();
+	}
 };
@@ -0,0 +1,159 @@
+﻿#include "CircuitScriptSource.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CircuitScriptStringSource::CircuitScriptStringSource(std::string text, const std::size_t chunkSize) : text(std::move(text)), chunkSize(chunkSize)
+{
+}
+
+std::string_view CircuitScriptStringSource::read()
+{
+	const auto chunk = std::string_view(text).substr(position, chunkSize);
+	position += chunk.size();
+	return chunk;
+}
+
+CircuitScriptViewSource::CircuitScriptViewSource(const std::string_view text, const std::size_t chunkSize) : text(text), chunkSize(chunkSize)
+{
+}
+
+std::string_view CircuitScriptViewSource::read()
+{
+	const auto chunk = text.substr(position, chunkSize);
+	position += chunk.size();
+	return chunk;
+}
+
+CircuitScriptStreamSource::CircuitScriptStreamSource(std::istream& in, const std::size_t chunkSize) : in(in), buffer(chunkSize, '\0')
+{
+}
+
+CircuitScriptStreamSource::CircuitScriptStreamSource(const std::string& path, const std::size_t chunkSize)
+	: owned(std::make_unique<std::ifstream>(path, std::ios::binary)), in(*owned), buffer(chunkSize, '\0')
+{
+	if (!in)
+	{
+		throw CircuitScriptSourceException("Cannot open " + path);
+	}
+}
+
+std::string_view CircuitScriptStreamSource::read()
+{
+	in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	// a short read at the end of the stream only sets eofbit and failbit, badbit means the stream itself failed, and the
+	// script must not silently end there
+	if (in.bad())
+	{
+		throw CircuitScriptSourceException("Cannot read the script");
+	}
+	return { buffer.data(), static_cast<std::size_t>(in.gcount()) };
+}
+
+CircuitScriptMappedFileSource::CircuitScriptMappedFileSource(const std::string& path, const std::size_t chunkSize) : chunkSize(chunkSize)
+{
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		file = nullptr;
+		throw CircuitScriptSourceException("Cannot open " + path);
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	size = static_cast<std::size_t>(fileSize.QuadPart);
+	if (size == 0)
+	{
+		return;
+	}
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping != nullptr)
+	{
+		data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (data == nullptr)
+	{
+		// the destructor does not run when the constructor throws
+		if (mapping != nullptr)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		throw CircuitScriptSourceException("Cannot map " + path);
+	}
+#else
+	const auto descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor == -1)
+	{
+		throw CircuitScriptSourceException("Cannot open " + path);
+	}
+	struct stat status{};
+	fstat(descriptor, &status);
+	size = static_cast<std::size_t>(status.st_size);
+	if (size != 0)
+	{
+		if (auto* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0); view != MAP_FAILED)
+		{
+			data = static_cast<const char*>(view);
+			madvise(view, size, MADV_SEQUENTIAL);
+			page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+		}
+	}
+	// the mapping outlives the descriptor
+	close(descriptor);
+	if (size != 0 && data == nullptr)
+	{
+		throw CircuitScriptSourceException("Cannot map " + path);
+	}
+#endif
+}
+
+CircuitScriptMappedFileSource::~CircuitScriptMappedFileSource()
+{
+#ifdef _WIN32
+	if (data != nullptr)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mapping != nullptr)
+	{
+		CloseHandle(mapping);
+	}
+	if (file != nullptr)
+	{
+		CloseHandle(file);
+	}
+#else
+	if (data != nullptr)
+	{
+		munmap(const_cast<char*>(data), size);
+	}
+#endif
+}
+
+std::string_view CircuitScriptMappedFileSource::read()
+{
+#ifndef _WIN32
+	// a chunk is only valid until the next call, so the pages before the current position can go, which keeps the resident
+	// size of the mapping to about one chunk, only the pages passed since the last call are released
+	if (const auto end = position / page * page; end > released)
+	{
+		madvise(const_cast<char*>(data) + released, end - released, MADV_DONTNEED);
+		released = end;
+	}
+#endif
+	const auto chunk = std::string_view(data, size).substr(position, chunkSize);
+	position += chunk.size();
+	return chunk;
+}
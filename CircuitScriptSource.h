@@ -0,0 +1,118 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/CircuitScriptSource.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class CircuitScriptSourceException final : public std::exception
+{
+public:
+	explicit CircuitScriptSourceException(const std::string& message) : std::exception(message.c_str())
+	{
+	}
+};
+
+// Where the text of a script comes from, it is handed to CircuitScriptLexer in chunks of bounded size so that a script never
+// has to be held in memory as a whole
+class CircuitScriptSource
+{
+public:
+	// 1 MiB
+	static constexpr std::size_t DefaultChunkSize = std::size_t{ 1 } << 20;
+
+	virtual ~CircuitScriptSource() = default;
+
+	// The next chunk of the script, an empty chunk means the end of the script. The chunk is valid until the next call
+	virtual std::string_view read() = 0;
+};
+
+// A script that is already in memory
+class CircuitScriptStringSource final : public CircuitScriptSource
+{
+	std::string text;
+	std::size_t position = 0;
+	std::size_t chunkSize;
+public:
+	explicit CircuitScriptStringSource(std::string text, std::size_t chunkSize = DefaultChunkSize);
+
+	std::string_view read() override;
+};
+
+// A script in memory that belongs to the caller, the chunks are views of it, so it must outlive the source
+class CircuitScriptViewSource final : public CircuitScriptSource
+{
+	std::string_view text;
+	std::size_t position = 0;
+	std::size_t chunkSize;
+public:
+	explicit CircuitScriptViewSource(std::string_view text, std::size_t chunkSize = DefaultChunkSize);
+
+	std::string_view read() override;
+};
+
+// A script read from a stream, e.g., a file or std::cin, only one chunk of it is buffered at a time
+class CircuitScriptStreamSource final : public CircuitScriptSource
+{
+	// set when the source opened the stream itself
+	std::unique_ptr<std::istream> owned;
+	std::istream& in;
+	std::string buffer;
+public:
+	explicit CircuitScriptStreamSource(std::istream& in, std::size_t chunkSize = DefaultChunkSize);
+
+	// Open the file at [path], throws CircuitScriptSourceException if it cannot be opened
+	explicit CircuitScriptStreamSource(const std::string& path, std::size_t chunkSize = DefaultChunkSize);
+
+	// Throws CircuitScriptSourceException if the stream fails, e.g., on an I/O error
+	std::string_view read() override;
+};
+
+// A script file mapped into memory, the chunks are views of the mapping, so the source needs no read buffer of its own,
+// CircuitScriptLexer still copies the chunk it is working on into its windows. The pages that have been handed out can be
+// dropped by the system at any time
+class CircuitScriptMappedFileSource final : public CircuitScriptSource
+{
+	const char* data = nullptr;
+	std::size_t size = 0;
+	std::size_t position = 0;
+	std::size_t chunkSize;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#else
+	std::size_t page = 1;
+	// the pages before this offset have already been released
+	std::size_t released = 0;
+#endif
+public:
+	// Map the file at [path], throws CircuitScriptSourceException if it cannot be opened or mapped
+	explicit CircuitScriptMappedFileSource(const std::string& path, std::size_t chunkSize = DefaultChunkSize);
+
+	CircuitScriptMappedFileSource(const CircuitScriptMappedFileSource&) = delete;
+
+	CircuitScriptMappedFileSource& operator=(const CircuitScriptMappedFileSource&) = delete;
+
+	~CircuitScriptMappedFileSource() override;
+
+	std::string_view read() override;
+};
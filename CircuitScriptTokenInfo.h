@@ -17,7 +17,9 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include <vector>
 
 #include "CircuitScriptTokenKind.h"
 
@@ -25,12 +27,47 @@ class CircuitScriptTokenInfo
 {
 public:
 	CircuitScriptTokenKind tokenKind;
-	std::string text;
+	// a view of the window of the lexer the token was lexed from, see CircuitScriptLexer for how long it stays valid
+	std::string_view text;
+	// the id of the identifier in the CircuitScriptIdentifierTable of the lexer, -1 if the token is not an identifier
+	int identifier = -1;
 
 	// compiler compliant
 	CircuitScriptTokenInfo() = default;
 
-	CircuitScriptTokenInfo(const CircuitScriptTokenKind tokenKind, std::string text) : tokenKind(tokenKind), text(std::move(text))
+	CircuitScriptTokenInfo(const CircuitScriptTokenKind tokenKind, const std::string_view text, const int identifier = -1) : tokenKind(tokenKind), text(text), identifier(identifier)
 	{
 	}
 };
+
+// The tokens of a script in the structure of arrays layout, a token is its kind and the span of its text in the source,
+// so no text is ever copied out of the source
+struct CircuitScriptTokenBuffer
+{
+	std::vector<CircuitScriptTokenKind> kinds;
+	std::vector<std::uint32_t> offsets;
+	std::vector<std::uint32_t> lengths;
+	// the ids of the identifiers, -1 for the other tokens
+	std::vector<std::int32_t> identifiers;
+
+	void push(const CircuitScriptTokenKind kind, const std::size_t offset, const std::size_t length, const int identifier = -1)
+	{
+		kinds.push_back(kind);
+		offsets.push_back(static_cast<std::uint32_t>(offset));
+		lengths.push_back(static_cast<std::uint32_t>(length));
+		identifiers.push_back(identifier);
+	}
+
+	std::size_t size() const
+	{
+		return kinds.size();
+	}
+
+	void clear()
+	{
+		kinds.clear();
+		offsets.clear();
+		lengths.clear();
+		identifiers.clear();
+	}
+};
@@ -17,8 +17,10 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
+#include <cstdint>
+#include <string>
 
-enum class CircuitScriptTokenKind
+enum class CircuitScriptTokenKind : std::uint8_t
 {
 	KeywordPower,
 	KeywordResistor,
@@ -0,0 +1,223 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/CompactGraph.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "Node.h"
+
+template <typename T>
+class Graph;
+
+// The scratch state of CompactGraph::forEachNonTrivialPath, pass the same workspace to consecutive searches so that the
+// visited mask and the explicit stack are allocated only once
+struct PathSearchWorkspace
+{
+	// one bit per vertex
+	std::vector<std::uint64_t> visited;
+	// the vertices of the current path, starting from the start vertex
+	std::vector<int> path;
+	// for each vertex in [path], the position in targets of the next successor to be explored
+	std::vector<int> cursors;
+};
+
+// An immutable compressed sparse row (CSR) snapshot of a Graph<T>
+// Vertices are renumbered to dense ids [0, vertexCount()) in the ascending order of their original indices, so that the
+// order-sensitive algorithms (e.g., Johnson's) behave exactly as they do on the Graph<T>. The successors of the vertex v
+// are stored in targets[offsets[v], offsets[v + 1]), and the payloads are kept in a separate side table so that the
+// traversals only ever touch the two int arrays
+template <typename T>
+class CompactGraph
+{
+	std::vector<int> offsets;
+	std::vector<int> targets;
+	std::vector<int> indices;
+	std::vector<T> payloads;
+public:
+	CompactGraph() : offsets{ 0 }
+	{
+	}
+
+	explicit CompactGraph(const Graph<T>& graph)
+	{
+		std::vector<const Node<T>*> nodes;
+		nodes.reserve(graph.adjacency().size());
+		for (const auto& node : std::views::keys(graph.adjacency()))
+		{
+			nodes.push_back(&node);
+		}
+		std::ranges::sort(nodes, [](const Node<T>* lhs, const Node<T>* rhs) { return lhs->index < rhs->index; });
+
+		indices.reserve(nodes.size());
+		payloads.reserve(nodes.size());
+		for (const auto* node : nodes)
+		{
+			indices.push_back(node->index);
+			payloads.push_back(node->data);
+		}
+
+		offsets.reserve(nodes.size() + 1);
+		offsets.push_back(0);
+		for (const auto* node : nodes)
+		{
+			// std::set keeps the successors in the ascending order of index, hence the targets of every row are sorted as well
+			for (const auto& successor : graph.adjacency().at(*node))
+			{
+				targets.push_back(denseId(successor.index));
+			}
+			offsets.push_back(static_cast<int>(targets.size()));
+		}
+	}
+
+	int vertexCount() const
+	{
+		return static_cast<int>(indices.size());
+	}
+
+	int edgeCount() const
+	{
+		return static_cast<int>(targets.size());
+	}
+
+	std::span<const int> successors(const int vertex) const
+	{
+		return { targets.data() + offsets[vertex], targets.data() + offsets[vertex + 1] };
+	}
+
+	// The index of the vertex in the original graph
+	int index(const int vertex) const
+	{
+		return indices[vertex];
+	}
+
+	const T& payload(const int vertex) const
+	{
+		return payloads[vertex];
+	}
+
+	Node<T> node(const int vertex) const
+	{
+		return Node<T>(payloads[vertex], indices[vertex]);
+	}
+
+	// Translate an index of the original graph into the dense id, returns -1 if there is no such vertex
+	int denseId(const int index) const
+	{
+		if (const auto itr = std::ranges::lower_bound(indices, index); itr != indices.end() && *itr == index)
+		{
+			return static_cast<int>(itr - indices.begin());
+		}
+		return -1;
+	}
+
+	int denseId(const Node<T>& node) const
+	{
+		return denseId(node.index);
+	}
+
+	// Get all vertices that are reachable from given vertex, as a mask indexed by dense id
+	std::vector<bool> reachable(const int vertex) const
+	{
+		std::vector<bool> visited(indices.size());
+		std::vector<int> stack{ vertex };
+		visited[vertex] = true;
+		while (!stack.empty())
+		{
+			const auto v = stack.back();
+			stack.pop_back();
+			for (const auto successor : successors(v))
+			{
+				if (!visited[successor])
+				{
+					visited[successor] = true;
+					stack.push_back(successor);
+				}
+			}
+		}
+		return visited;
+	}
+
+	// Enumerate all non trivial paths (i.e., those who contains more than one intermediate node) between start and end by a
+	// depth-first search with an explicit stack, so that deep circuits do not overflow the call stack. Every path is handed
+	// to [sink] as a span of dense ids which excludes both start and end, the span points into [workspace] and is only
+	// valid during the call. There are no paths from a vertex to itself, the cycles through it are not enumerated
+	template <typename Sink>
+	void forEachNonTrivialPath(const int start, const int end, PathSearchWorkspace& workspace, Sink&& sink) const
+	{
+		if (start == end)
+		{
+			return;
+		}
+		auto& [visited, path, cursors] = workspace;
+		visited.assign((indices.size() + 63) / 64, 0);
+		path.clear();
+		cursors.clear();
+
+		const auto mark = [&visited](const int vertex) { visited[vertex >> 6] |= std::uint64_t{ 1 } << (vertex & 63); };
+		const auto unmark = [&visited](const int vertex) { visited[vertex >> 6] &= ~(std::uint64_t{ 1 } << (vertex & 63)); };
+		const auto marked = [&visited](const int vertex) { return (visited[vertex >> 6] >> (vertex & 63) & 1) != 0; };
+
+		mark(start);
+		path.push_back(start);
+		cursors.push_back(offsets[start]);
+		while (!path.empty())
+		{
+			const auto vertex = path.back();
+			if (cursors.back() == offsets[vertex + 1])
+			{
+				unmark(vertex);
+				path.pop_back();
+				cursors.pop_back();
+				continue;
+			}
+			const auto successor = targets[cursors.back()++];
+			if (successor == end)
+			{
+				if (path.size() > 1)
+				{
+					sink(std::span<const int>(path.data() + 1, path.size() - 1));
+				}
+			}
+			else if (!marked(successor))
+			{
+				mark(successor);
+				path.push_back(successor);
+				cursors.push_back(offsets[successor]);
+			}
+		}
+	}
+
+	template <typename Sink>
+	void forEachNonTrivialPath(const int start, const int end, Sink&& sink) const
+	{
+		PathSearchWorkspace workspace;
+		forEachNonTrivialPath(start, end, workspace, std::forward<Sink>(sink));
+	}
+
+	// Get all non trivial paths between start and end, the paths are expressed in dense ids and exclude both start and end
+	std::vector<std::vector<int>> nonTrivialPaths(const int start, const int end) const
+	{
+		std::vector<std::vector<int>> allPaths;
+		forEachNonTrivialPath(start, end, [&allPaths](const std::span<const int> path) { allPaths.emplace_back(path.begin(), path.end()); });
+		return allPaths;
+	}
+};
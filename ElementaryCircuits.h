@@ -19,9 +19,14 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <span>
+#include <unordered_set>
 
-#include "Graph.h"
+#include "CompactGraph.h"
 #include "StrongComponents.h"
+#include "WorkStealingThreadPool.h"
 
 // Find all elementary circuits in a graph, where "elementary" means no node can occur more than one times in a loop
 // based on the research of Donald. B. Johnson, for the correctness proof, complexity analysis, and the original paper
@@ -29,104 +34,275 @@
 template <typename T>
 class ElementaryCircuits
 {
-	Graph<T> graph;
-	std::vector<Node<T>> stack;
-	std::unordered_map<Node<T>, std::unordered_set<Node<T>>> blockMap;
-	std::unordered_set<Node<T>> blocked;
-	std::vector<std::set<Node<T>>> result;
-	int s;
-
-	void unblock(const Node<T>& node)
+	// The state of the search for the circuits through a single start vertex, the searches from different start vertices are
+	// independent, so the parallel mode keeps one of these for every worker
+	struct Search
 	{
-		for (const Node<T>& n : blockMap[node] | std::views::filter([this](const Node<T>& it) { return blocked.contains(it); }))
+		const CompactGraph<T>& graph;
+		StrongComponents<T> strongComponents;
+		std::vector<int> stack;
+		std::vector<std::unordered_set<int>> blockMap;
+		std::vector<bool> blocked;
+		// the strong component that is currently being searched, i.e., the A_k in Johnson's paper
+		std::vector<bool> component;
+		int s = 0;
+		// set once the visitor asks to stop, the recursion then unwinds without exploring anything else
+		bool stopped = false;
+
+		explicit Search(const CompactGraph<T>& graph)
+			: graph(graph), strongComponents(graph), blockMap(graph.vertexCount()), blocked(graph.vertexCount()), component(graph.vertexCount())
 		{
-			unblock(n);
 		}
-		blocked.erase(node);
-	}
-
-	bool circuit(const Node<T>& node)
-	{
-		auto find = false;
-		stack.push_back(node);
-		blocked.insert(node);
 
-		for (const Node<T>& successor : graph.adjacencyList[node])
+		void unblock(const int node)
 		{
-			if (successor.index == s)
+			blocked[node] = false;
+			while (!blockMap[node].empty())
 			{
-				std::set<Node<T>> set;
-				std::ranges::transform(stack, std::inserter(set, set.begin()), std::identity{});
-				result.push_back(set);
-				find = true;
+				const auto n = *blockMap[node].begin();
+				blockMap[node].erase(blockMap[node].begin());
+				if (blocked[n])
+				{
+					unblock(n);
+				}
 			}
-			else if (!blocked.contains(successor))
+		}
+
+		template <typename Visitor>
+		bool circuit(const int node, Visitor& visitor)
+		{
+			auto find = false;
+			stack.push_back(node);
+			blocked[node] = true;
+
+			for (const int successor : graph.successors(node))
 			{
-				if (circuit(successor))
+				if (!component[successor])
+				{
+					continue;
+				}
+				if (successor == s)
 				{
 					find = true;
+					if (!visitor(std::span<const int>(stack)))
+					{
+						stopped = true;
+					}
+				}
+				else if (!blocked[successor])
+				{
+					if (circuit(successor, visitor))
+					{
+						find = true;
+					}
+				}
+				if (stopped)
+				{
+					// the blocked sets are left as they are, run() resets them before the next search anyway
+					stack.pop_back();
+					return find;
+				}
+			}
+
+			if (find)
+			{
+				unblock(node);
+			}
+			else
+			{
+				for (const int n : graph.successors(node))
+				{
+					if (component[n])
+					{
+						blockMap[n].insert(node);
+					}
 				}
 			}
+			stack.pop_back();
+			return find;
 		}
 
-		if (find)
+		// Visit all the circuits whose least vertex is [start], where [leastComponent] is the strong component of [start] in the
+		// sub graph of the vertices from [start] on, returns false if the visitor asked to stop
+		template <typename Visitor>
+		bool run(const int start, const std::span<const int> leastComponent, Visitor& visitor)
 		{
-			unblock(node);
+			if (leastComponent.size() <= 1)
+			{
+				return true;
+			}
+			s = start;
+			stopped = false;
+			for (const int n : leastComponent)
+			{
+				blocked[n] = false;
+				blockMap[n].clear();
+				component[n] = true;
+			}
+			circuit(s, visitor);
+			for (const int n : leastComponent)
+			{
+				component[n] = false;
+			}
+			return !stopped;
+		}
+
+		template <typename Visitor>
+		bool run(const int start, Visitor& visitor)
+		{
+			const auto leastComponent = strongComponents.leastComponent(start);
+			return run(start, std::span<const int>(leastComponent), visitor);
 		}
-		else
+	};
+
+	const CompactGraph<T>& graph;
+
+	// A vertex that is alone in its strong component of the whole graph cannot be on any circuit of its sub graphs either
+	std::vector<int> startVertices() const
+	{
+		std::vector<int> starts;
+		for (const auto& component : StrongComponents(graph).denseStrongComponents())
 		{
-			for (const Node<T>& n : graph.adjacencyList[node])
+			if (component.size() > 1)
 			{
-				blockMap[n].insert(node);
+				std::ranges::copy(component, std::back_inserter(starts));
 			}
 		}
-		stack.pop_back();
-		return find;
+		std::ranges::sort(starts);
+		return starts;
+	}
+
+	std::set<Node<T>> toNodes(const std::span<const int> circuit) const
+	{
+		std::set<Node<T>> nodes;
+		std::ranges::transform(circuit, std::inserter(nodes, nodes.begin()), [this](const int n) { return graph.node(n); });
+		return nodes;
 	}
 public:
-	explicit ElementaryCircuits(const Graph<T>& graph) : graph(graph), s(0)
+	explicit ElementaryCircuits(const CompactGraph<T>& graph) : graph(graph)
 	{
-		for (auto [vertex, _] : graph.adjacencyList)
-		{
-			blockMap[vertex] = std::unordered_set<Node<T>>();
-		}
 	}
 
-	std::vector<std::set<Node<T>>> elementaryCircuits()
+	// Hand every elementary circuit to [visitor] as it is found, without collecting them first
+	// The circuit is passed as a span of dense ids in the order of the cycle, starting from its least vertex, the span points
+	// into the stack of the search and is only valid during the call. The visitor returns false to stop the enumeration,
+	// which matters since the number of circuits can be exponential in the size of the graph
+	template <typename Visitor>
+	void forEachCircuit(Visitor&& visitor)
 	{
-		s = graph.vertices().begin()->index;
-
-		const auto sizePredicate = [](const std::set<Node<T>>& set) { return set.size() > 1; };
-		const auto size = static_cast<int>(graph.vertices().size());
-		while (s < size)
+		Search search(graph);
+		// The sub graph of the vertices from s on is never materialized, instead the strong components of the remaining
+		// vertices are maintained as the outer loop removes them one by one. Removing s can only split the component that
+		// contained it, so only that component is searched again, and the components that never lose a vertex are computed
+		// once for the whole enumeration
+		auto condensation = search.strongComponents.condensation();
+		auto& componentOf = condensation.componentOf;
+		auto& components = condensation.components;
+		for (int s = 0; s < graph.vertexCount(); s++)
 		{
-			if (auto subGraphStrongComponents = StrongComponents(graph.subGraph(s)).strongComponents();
-				!subGraphStrongComponents.empty() && std::ranges::find_if(subGraphStrongComponents, sizePredicate) != subGraphStrongComponents.end())
+			const auto id = componentOf[s];
+			auto& members = components[id];
+			if (!search.run(s, std::span<const int>(members), visitor))
+			{
+				return;
+			}
+			// the members are sorted, and every vertex below s has already been removed, so s is the first one
+			members.erase(members.begin());
+			if (members.size() > 1)
 			{
-				std::vector<std::set<Node<T>>> sortedFilteredNodes;
-				for (const std::set<Node<T>>& subGraphStrongComponent : subGraphStrongComponents)
+				auto pieces = search.strongComponents.inducedStrongComponents(members);
+				members = std::move(pieces.back());
+				pieces.pop_back();
+				for (auto& piece : pieces)
 				{
-					if (subGraphStrongComponent.size() > 1)
+					for (const int vertex : piece)
 					{
-						sortedFilteredNodes.push_back(subGraphStrongComponent);
+						componentOf[vertex] = static_cast<int>(components.size());
 					}
+					components.push_back(std::move(piece));
 				}
-				std::sort(sortedFilteredNodes.begin(), sortedFilteredNodes.end(), [](const std::set<Node<T>>& lhs, const std::set<Node<T>>& rhs) { return lhs.begin()->index < rhs.begin()->index; });
-				std::set<Node<T>> leastIndexNodes = *sortedFilteredNodes.begin();
-				auto leastIndexNode = leastIndexNodes.begin();
-				s = leastIndexNode->index;
-				for (const Node<T>& n : leastIndexNodes)
-				{
-					blocked.erase(n);
-					blockMap[n].clear();
-				}
-				circuit(*leastIndexNode);
-				s++;
 			}
-			else
+		}
+	}
+
+	// Same as forEachCircuit(visitor), but searches the different start vertices on the workers of [pool], hence the circuits
+	// arrive in no particular order and [visitor] is called concurrently. Once any call returns false, the searches that are
+	// still running stop and the remaining ones are skipped
+	template <typename Visitor>
+	void forEachCircuit(WorkStealingThreadPool& pool, Visitor&& visitor)
+	{
+		const auto starts = startVertices();
+		std::vector<std::unique_ptr<Search>> searches(pool.size());
+		std::atomic<bool> stopped = false;
+		auto stoppable = [&visitor, &stopped](const std::span<const int> circuit)
+		{
+			if (stopped.load(std::memory_order_relaxed) || !visitor(circuit))
 			{
-				break;
+				stopped.store(true, std::memory_order_relaxed);
+				return false;
 			}
+			return true;
+		};
+		for (const int start : starts)
+		{
+			pool.submit([this, &pool, &searches, &stopped, &stoppable, start]
+				{
+					if (stopped.load(std::memory_order_relaxed))
+					{
+						return;
+					}
+					auto& search = searches[pool.workerIndex()];
+					if (search == nullptr)
+					{
+						search = std::make_unique<Search>(graph);
+					}
+					search->run(start, stoppable);
+				});
+		}
+		pool.wait();
+	}
+
+	std::vector<std::set<Node<T>>> elementaryCircuits()
+	{
+		std::vector<std::set<Node<T>>> result;
+		forEachCircuit([this, &result](const std::span<const int> circuit)
+			{
+				result.push_back(toNodes(circuit));
+				return true;
+			});
+		return result;
+	}
+
+	// Search the circuits of different start vertices on the workers of [pool], the circuits are merged in the order of their
+	// start vertices, so the result is exactly the same as the one of the sequential mode
+	std::vector<std::set<Node<T>>> elementaryCircuits(WorkStealingThreadPool& pool)
+	{
+		const auto starts = startVertices();
+		std::vector<std::unique_ptr<Search>> searches(pool.size());
+		std::vector<std::vector<std::set<Node<T>>>> results(starts.size());
+		for (std::size_t i = 0; i < starts.size(); i++)
+		{
+			pool.submit([this, &pool, &searches, &results, &starts, i]
+				{
+					auto& search = searches[pool.workerIndex()];
+					if (search == nullptr)
+					{
+						search = std::make_unique<Search>(graph);
+					}
+					auto collect = [this, &circuits = results[i]](const std::span<const int> circuit)
+					{
+						circuits.push_back(toNodes(circuit));
+						return true;
+					};
+					search->run(starts[i], collect);
+				});
+		}
+		pool.wait();
+
+		std::vector<std::set<Node<T>>> result;
+		for (auto& circuits : results)
+		{
+			std::ranges::move(circuits, std::back_inserter(result));
 		}
 		return result;
 	}
@@ -0,0 +1,179 @@
+﻿#include "EquationEmitter.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+	// The tokens that every format writes around the parts of an equation
+	struct EquationSyntax
+	{
+		std::string_view seriesOpen, seriesClose;
+		// written around a series that is itself a term of another series
+		std::string_view nestedSeriesOpen, nestedSeriesClose;
+		// written in place of a series whose terms are all empty
+		std::string_view emptySeries;
+		std::string_view termSeparator;
+		// written after every term but the voltage of the source
+		std::string_view current;
+		// written instead of current after the terms of a series inside a branch of a parallel, the branches of a parallel
+		// add up admittances, and the current is written once after the whole parallel
+		std::string_view branchCurrent;
+		std::string_view parallelOpen, parallelClose;
+		std::string_view branchOpen, branchClose, branchSeparator;
+		std::string_view impedanceOpen, sourceOpen, leafClose;
+	};
+
+	constexpr EquationSyntax Syntaxes[] = {
+		// Text
+		{ "", "", "", "", "", "+", "I", "I", "{1/", "}", "[1/", "]", "+", "", "", "" },
+		// Latex
+		{ "", "", "\\left(", "\\right)", "0", " + ", " I", "", "\\frac{1}{", "}", "\\frac{1}{", "}", " + ", "", "", "" },
+		// Json
+		{ "{\"kind\":\"series\",\"terms\":[", "]}", "", "", "", ",", "", "", "{\"kind\":\"parallel\",\"branches\":[", "]}", "", "", ",",
+		  "{\"kind\":\"impedance\",\"value\":\"", "{\"kind\":\"source\",\"value\":\"", "\"}" },
+		// NumPy
+		{ "", "", "(", ")", "0", " + ", "*I", "", "1/(", ")", "1/(", ")", " + ", "", "", "" }
+	};
+
+	// Write the text of a leaf in the literal syntax of [format]
+	template <typename Sink>
+	void Literal(const std::string_view text, const EquationFormat format, Sink& sink)
+	{
+		switch (format)
+		{
+		case EquationFormat::Text:
+		case EquationFormat::Latex:
+			sink(text);
+			break;
+		case EquationFormat::Json:
+			for (std::size_t begin = 0, end; begin < text.size(); begin = end + 1)
+			{
+				end = std::min(text.find_first_of("\"\\", begin), text.size());
+				sink(text.substr(begin, end - begin));
+				if (end < text.size())
+				{
+					sink("\\");
+					sink(text.substr(end, 1));
+				}
+			}
+			break;
+		case EquationFormat::NumPy:
+			// the imaginary unit is written in front of the number in the calculator and behind it in Python, e.g., (-j6.77)
+			// turns into (-6.77j)
+			if (const auto j = text.find('j'); j != std::string_view::npos)
+			{
+				const auto number = text.substr(j + 1, text.find(')', j) - j - 1);
+				sink(text.substr(0, j));
+				sink(number);
+				sink("j");
+				sink(text.substr(j + 1 + number.size()));
+			}
+			else
+			{
+				sink(text);
+			}
+			break;
+		}
+	}
+}
+
+template <typename Sink>
+void EquationEmitter::emit(const ExpressionId id, Sink&& sink) const
+{
+	const auto& syntax = Syntaxes[static_cast<int>(format)];
+
+	struct Frame
+	{
+		ExpressionId id;
+		// the next operand to be written
+		std::uint32_t next;
+		bool nested;
+		// whether the expression is inside a branch of a parallel
+		bool branch;
+		bool any;
+	};
+	std::vector<Frame> stack;
+	const auto open = [&stack, &syntax, &sink, this](const ExpressionId e, const bool nested, const bool branch)
+	{
+		switch (expressions[e].kind)
+		{
+		case ExpressionKind::Impedance:
+		case ExpressionKind::Source:
+			sink(expressions[e].kind == ExpressionKind::Source ? syntax.sourceOpen : syntax.impedanceOpen);
+			Literal(expressions.text(e), format, sink);
+			sink(syntax.leafClose);
+			return false;
+		case ExpressionKind::Series:
+			sink(nested ? syntax.nestedSeriesOpen : "");
+			sink(syntax.seriesOpen);
+			sink(expressions.empty(e) ? syntax.emptySeries : "");
+			break;
+		case ExpressionKind::Parallel:
+			sink(syntax.parallelOpen);
+			break;
+		}
+		stack.push_back({ e, 0, nested, branch, false });
+		return true;
+	};
+	const auto close = [&syntax, &sink, this](const Frame& parent, const ExpressionId child)
+	{
+		if (expressions[parent.id].kind == ExpressionKind::Series)
+		{
+			sink(expressions[child].kind == ExpressionKind::Source ? "" : parent.branch ? syntax.branchCurrent : syntax.current);
+		}
+		else
+		{
+			sink(syntax.branchClose);
+		}
+	};
+
+	if (!open(id, false, false))
+	{
+		return;
+	}
+	while (!stack.empty())
+	{
+		auto& frame = stack.back();
+		const auto operands = expressions.operands(frame.id);
+		const auto series = expressions[frame.id].kind == ExpressionKind::Series;
+		// the terms without impedance, e.g., grounds, leave no trace, not even their delimiter
+		while (series && frame.next < operands.size() && expressions.empty(operands[frame.next]))
+		{
+			frame.next++;
+		}
+		if (frame.next < operands.size())
+		{
+			const auto child = operands[frame.next++];
+			sink(!frame.any ? "" : series ? syntax.termSeparator : syntax.branchSeparator);
+			sink(series ? "" : syntax.branchOpen);
+			frame.any = true;
+			// the frame may move when the child is pushed
+			const auto parent = frame;
+			if (!open(child, series && expressions[child].kind == ExpressionKind::Series, frame.branch || !series))
+			{
+				close(parent, child);
+			}
+			continue;
+		}
+
+		const auto finished = frame;
+		stack.pop_back();
+		sink(expressions[finished.id].kind == ExpressionKind::Series ? syntax.seriesClose : syntax.parallelClose);
+		sink(finished.nested ? syntax.nestedSeriesClose : "");
+		if (!stack.empty())
+		{
+			close(stack.back(), finished.id);
+		}
+	}
+}
+
+void EquationEmitter::emit(const ExpressionId id, std::ostream& out) const
+{
+	emit(id, [&out](const std::string_view text) { out.write(text.data(), static_cast<std::streamsize>(text.size())); });
+}
+
+void EquationEmitter::emit(const ExpressionId id, std::string& buffer) const
+{
+	emit(id, [&buffer](const std::string_view text) { buffer.append(text); });
+}
@@ -0,0 +1,61 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/EquationEmitter.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ExpressionDag.h"
+
+enum class EquationFormat
+{
+	// the notation of the calculator, e.g., -10.00+4.70I+{1/[1/5.00I]+[1/j15.71I]}I
+	Text,
+	// e.g., -10.00 + 4.70 I + \frac{1}{\frac{1}{5.00} + \frac{1}{j15.71}} I, the current is only written after the terms of the
+	// outermost series, the branches of a parallel are plain impedances
+	Latex,
+	// the syntax tree, e.g., {"kind":"series","terms":[{"kind":"source","value":"-10.00"},...]}
+	Json,
+	// a Python expression of the complex impedances in which I may be a NumPy array, e.g., -10.00 + 4.70*I + 1/(1/(5.00) + 1/(15.71j))*I,
+	// which evaluates to zero when I is the current drawn from the supply
+	NumPy
+};
+
+// Writes an equation of an ExpressionDag out piece by piece as it walks the DAG, the equation is never held in memory as a
+// whole, and the walk keeps its own stack, so the memory it needs is proportional to the depth of the equation rather than
+// to its length or to the size of the DAG
+class EquationEmitter
+{
+	const ExpressionDag& expressions;
+	EquationFormat format;
+
+	template <typename Sink>
+	void emit(ExpressionId id, Sink&& sink) const;
+public:
+	explicit EquationEmitter(const ExpressionDag& expressions, const EquationFormat format = EquationFormat::Text)
+		: expressions(expressions), format(format)
+	{
+	}
+
+	void emit(ExpressionId id, std::ostream& out) const;
+
+	// Append the equation to [buffer]
+	void emit(ExpressionId id, std::string& buffer) const;
+};
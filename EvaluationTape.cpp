@@ -0,0 +1,102 @@
+﻿#include "EvaluationTape.h"
+
+#include <algorithm>
+
+#include "Impedance.h"
+
+EvaluationTape::EvaluationTape(const CompactGraph<CircuitScriptGraphNodeKind>& graph, const SeriesParallelTree& tree, const CircuitComponentTable& components)
+	: registerCount(0), valueCount(graph.vertexCount())
+{
+	instructions.reserve(tree.nodes.size() * 2);
+	auto top = 0;
+	for (const auto& node : tree.nodes)
+	{
+		switch (node.kind)
+		{
+		case SeriesParallelNodeKind::Unit:
+		{
+			auto opcode = TapeOpcode::LoadZero;
+			switch (components.kind(graph.index(node.unit)))
+			{
+			case CircuitScriptGraphNodeKind::Resistor:
+				opcode = TapeOpcode::LoadResistor;
+				break;
+			case CircuitScriptGraphNodeKind::Capacitor:
+				opcode = TapeOpcode::LoadCapacitor;
+				break;
+			case CircuitScriptGraphNodeKind::Inductor:
+				opcode = TapeOpcode::LoadInductor;
+				break;
+			case CircuitScriptGraphNodeKind::Power:
+			case CircuitScriptGraphNodeKind::Ground:
+				break;
+			}
+			instructions.push_back({ opcode, top++, node.unit });
+			registerCount = std::max(registerCount, top);
+			break;
+		}
+		case SeriesParallelNodeKind::Series:
+		case SeriesParallelNodeKind::Parallel:
+		{
+			// the children are the topmost registers, fold them into the first one
+			const auto first = top - static_cast<int>(node.children.size());
+			const auto opcode = node.kind == SeriesParallelNodeKind::Series ? TapeOpcode::SeriesAdd : TapeOpcode::ParallelCombine;
+			for (auto r = first + 1; r < top; r++)
+			{
+				instructions.push_back({ opcode, first, r });
+			}
+			top = first + 1;
+			break;
+		}
+		}
+	}
+}
+
+std::vector<double> EvaluationTape::unitValues(const CompactGraph<CircuitScriptGraphNodeKind>& graph, const CircuitComponentTable& components)
+{
+	std::vector<double> values(graph.vertexCount());
+	for (int vertex = 0; vertex < graph.vertexCount(); vertex++)
+	{
+		values[vertex] = components.value(graph.index(vertex));
+	}
+	return values;
+}
+
+std::complex<double> EvaluationTape::execute(const std::span<const double> values, const double frequencyInHz, std::vector<std::complex<double>>& registers) const
+{
+	using namespace CircuitCalculator;
+
+	const auto angularFrequency = Impedance::AngularFrequency(frequencyInHz);
+	registers.resize(registerCount);
+	for (const auto& [opcode, destination, operand] : instructions)
+	{
+		switch (opcode)
+		{
+		case TapeOpcode::LoadResistor:
+			registers[destination] = Impedance::Resistor(values[operand]);
+			break;
+		case TapeOpcode::LoadCapacitor:
+			registers[destination] = Impedance::Capacitor(values[operand], angularFrequency);
+			break;
+		case TapeOpcode::LoadInductor:
+			registers[destination] = Impedance::Inductor(values[operand], angularFrequency);
+			break;
+		case TapeOpcode::LoadZero:
+			registers[destination] = {};
+			break;
+		case TapeOpcode::SeriesAdd:
+			registers[destination] += registers[operand];
+			break;
+		case TapeOpcode::ParallelCombine:
+			registers[destination] = Impedance::Parallel(registers[destination], registers[operand]);
+			break;
+		}
+	}
+	return registers.empty() ? std::complex<double>() : registers.front();
+}
+
+std::complex<double> EvaluationTape::execute(const std::span<const double> values, const double frequencyInHz) const
+{
+	std::vector<std::complex<double>> registers;
+	return execute(values, frequencyInHz, registers);
+}
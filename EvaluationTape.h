@@ -0,0 +1,87 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/EvaluationTape.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <complex>
+#include <span>
+#include <vector>
+
+#include "CircuitComponentTable.h"
+#include "CircuitScriptGraphNode.h"
+#include "CompactGraph.h"
+#include "SeriesParallelDecomposition.h"
+
+enum class TapeOpcode
+{
+	// registers[destination] = impedance of the unit whose value is values[operand]
+	LoadResistor,
+	LoadCapacitor,
+	LoadInductor,
+	// registers[destination] = 0, for the units without impedance, e.g., grounds
+	LoadZero,
+	// registers[destination] = registers[operand] + registers[destination]
+	SeriesAdd,
+	// registers[destination] = registers[operand] // registers[destination]
+	ParallelCombine
+};
+
+struct TapeInstruction
+{
+	TapeOpcode opcode;
+	int destination;
+	int operand;
+};
+
+// The series-parallel structure of a circuit compiled into a flat list of instructions
+// The structure only depends on the topology, so once compiled, evaluating the circuit with other unit values or at another
+// frequency is a single linear pass over the instructions. Registers are allocated as a stack along the post order of the
+// decomposition tree, and the children of a node stay on it until the node folds them, so the register file holds, for the
+// worst leaf, one register for every finished sibling of the leaf and of its ancestors plus one for the leaf itself. That
+// grows with both the depth and the fan-out of the tree and never exceeds the number of units, [registers] is the exact count
+class EvaluationTape
+{
+	std::vector<TapeInstruction> instructions;
+	int registerCount;
+	int valueCount;
+public:
+	EvaluationTape(const CompactGraph<CircuitScriptGraphNodeKind>& graph, const SeriesParallelTree& tree, const CircuitComponentTable& components);
+
+	const std::vector<TapeInstruction>& code() const
+	{
+		return instructions;
+	}
+
+	int registers() const
+	{
+		return registerCount;
+	}
+
+	// The size of the value array that the tape expects, i.e., the number of units in the graph it was compiled from
+	int values() const
+	{
+		return valueCount;
+	}
+
+	// Read the value of every unit (resistance, capacitance or inductance) of the graph, indexed by the dense id
+	static std::vector<double> unitValues(const CompactGraph<CircuitScriptGraphNodeKind>& graph, const CircuitComponentTable& components);
+
+	// Compute the equivalent impedance, [registers] is the scratch space and can be reused across executions
+	std::complex<double> execute(std::span<const double> values, double frequencyInHz, std::vector<std::complex<double>>& registers) const;
+
+	std::complex<double> execute(std::span<const double> values, double frequencyInHz) const;
+};
@@ -0,0 +1,73 @@
+﻿#include "ExpressionDag.h"
+
+#include <algorithm>
+#include <functional>
+
+std::size_t ExpressionDag::hash(const ExpressionKind kind, const std::string_view text, const std::span<const ExpressionId> operands)
+{
+	// boost::hash_combine
+	auto seed = static_cast<std::size_t>(kind);
+	const auto combine = [&seed](const std::size_t value) { seed ^= value + 0x9E3779B97F4A7C15 + (seed << 6) + (seed >> 2); };
+	combine(std::hash<std::string_view>{}(text));
+	for (const auto operand : operands)
+	{
+		combine(operand);
+	}
+	return seed;
+}
+
+ExpressionId ExpressionDag::leaf(const ExpressionKind kind, const std::string_view text)
+{
+	const auto h = hash(kind, text, {});
+	for (auto [itr, end] = interned.equal_range(h); itr != end; ++itr)
+	{
+		if (const auto& existing = expressions[itr->second]; existing.kind == kind && texts[existing.first] == text)
+		{
+			return itr->second;
+		}
+	}
+	const auto id = static_cast<ExpressionId>(expressions.size());
+	expressions.push_back({ kind, static_cast<std::uint32_t>(texts.size()), 0, kind == ExpressionKind::Impedance && text.empty() });
+	texts.emplace_back(text);
+	interned.emplace(h, id);
+	return id;
+}
+
+ExpressionId ExpressionDag::composite(const ExpressionKind kind, const std::span<const ExpressionId> operands)
+{
+	const auto h = hash(kind, {}, operands);
+	for (auto [itr, end] = interned.equal_range(h); itr != end; ++itr)
+	{
+		if (expressions[itr->second].kind == kind && std::ranges::equal(this->operands(itr->second), operands))
+		{
+			return itr->second;
+		}
+	}
+	const auto id = static_cast<ExpressionId>(expressions.size());
+	// the operands are interned before their parents, so their flags are already known
+	const auto empty = kind == ExpressionKind::Series && std::ranges::all_of(operands, [this](const ExpressionId operand) { return expressions[operand].empty; });
+	expressions.push_back({ kind, static_cast<std::uint32_t>(operandPool.size()), static_cast<std::uint32_t>(operands.size()), empty });
+	operandPool.insert(operandPool.end(), operands.begin(), operands.end());
+	interned.emplace(h, id);
+	return id;
+}
+
+ExpressionId ExpressionDag::impedance(const std::string_view text)
+{
+	return leaf(ExpressionKind::Impedance, text);
+}
+
+ExpressionId ExpressionDag::source(const std::string_view text)
+{
+	return leaf(ExpressionKind::Source, text);
+}
+
+ExpressionId ExpressionDag::series(const std::span<const ExpressionId> terms)
+{
+	return composite(ExpressionKind::Series, terms);
+}
+
+ExpressionId ExpressionDag::parallel(const std::span<const ExpressionId> branches)
+{
+	return composite(ExpressionKind::Parallel, branches);
+}
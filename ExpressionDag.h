@@ -0,0 +1,103 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/ExpressionDag.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using ExpressionId = std::uint32_t;
+
+enum class ExpressionKind
+{
+	// the impedance of a unit, a current flows through it, i.e., it is followed by I in a series
+	Impedance,
+	// the voltage of the power supply, it is not multiplied by the current
+	Source,
+	// the operands are the terms of a sum, the terms that render to nothing are skipped
+	Series,
+	// the operands are the branches, each of them is usually a Series
+	Parallel
+};
+
+struct Expression
+{
+	ExpressionKind kind;
+	// the position of the operands in the operand pool for Series and Parallel, the position of the text for the leaves
+	std::uint32_t first;
+	std::uint32_t count;
+	// whether the expression renders to nothing, i.e., it is an impedance without text or a series of such terms
+	bool empty;
+};
+
+// An interned DAG of the equations of a circuit
+// Every expression is a 32-bit id into a flat table, composite expressions refer to their operands by id, and structurally
+// equal expressions are hash-consed into the same id, so a sub-equation that appears in many places is stored once no matter
+// how deep it is nested. The text is only produced at the very end, by EquationEmitter
+class ExpressionDag
+{
+	std::vector<Expression> expressions;
+	std::vector<ExpressionId> operandPool;
+	std::vector<std::string> texts;
+	// the structural hash of every expression, the ids with the same hash are compared field by field
+	std::unordered_multimap<std::size_t, ExpressionId> interned;
+
+	static std::size_t hash(ExpressionKind kind, std::string_view text, std::span<const ExpressionId> operands);
+
+	ExpressionId leaf(ExpressionKind kind, std::string_view text);
+
+	ExpressionId composite(ExpressionKind kind, std::span<const ExpressionId> operands);
+public:
+	ExpressionId impedance(std::string_view text);
+
+	ExpressionId source(std::string_view text);
+
+	ExpressionId series(std::span<const ExpressionId> terms);
+
+	ExpressionId parallel(std::span<const ExpressionId> branches);
+
+	const Expression& operator[](const ExpressionId id) const
+	{
+		return expressions[id];
+	}
+
+	std::span<const ExpressionId> operands(const ExpressionId id) const
+	{
+		return { operandPool.data() + expressions[id].first, expressions[id].count };
+	}
+
+	bool empty(const ExpressionId id) const
+	{
+		return expressions[id].empty;
+	}
+
+	// The text of a leaf
+	std::string_view text(const ExpressionId id) const
+	{
+		return texts[expressions[id].first];
+	}
+
+	// The number of distinct expressions
+	std::size_t size() const
+	{
+		return expressions.size();
+	}
+};
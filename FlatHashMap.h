@@ -0,0 +1,324 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/FlatHashMap.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Node.h"
+
+// The finalizer of MurmurHash3, every bit of [value] affects every bit of the result, so that keys which only differ in
+// their high bits, or are small consecutive integers, still spread over all the buckets of a power-of-two table
+inline std::uint64_t HashMix(std::uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCD;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53;
+	value ^= value >> 33;
+	return value;
+}
+
+// The hash of FlatHashMap, std::hash of most integral types is the identity, which is mixed before use
+template <typename T>
+struct FlatHash
+{
+	std::size_t operator()(const T& value) const
+	{
+		return HashMix(std::hash<T>{}(value));
+	}
+};
+
+// An edge or the two end points of a path, both indices are packed into one word, so (a, b) and (b, a) are different keys
+template <typename T>
+struct FlatHash<std::pair<Node<T>, Node<T>>>
+{
+	std::size_t operator()(const std::pair<Node<T>, Node<T>>& pair) const
+	{
+		return HashMix(static_cast<std::uint64_t>(static_cast<std::uint32_t>(pair.first.index)) << 32 | static_cast<std::uint32_t>(pair.second.index));
+	}
+};
+
+// An open-addressing hash map with linear probing over a single flat array of slots
+// A lookup hashes once and then scans neighbouring slots of the same array, instead of following a bucket list into a
+// separately allocated node for every element as std::unordered_map does. Erasing shifts the following elements of the
+// probe sequence back, so no tombstone is ever left behind. Like std::unordered_map, the iteration order is unspecified, but
+// unlike it, inserting or erasing an element invalidates all the iterators and references into the map
+template <typename Key, typename Value, typename Hash = FlatHash<Key>>
+class FlatHashMap
+{
+	using Element = std::pair<const Key, Value>;
+
+	std::vector<std::optional<Element>> slots;
+	std::size_t count = 0;
+
+	std::size_t mask() const
+	{
+		return slots.size() - 1;
+	}
+
+	std::size_t home(const Key& key) const
+	{
+		return Hash{}(key) & mask();
+	}
+
+	// The slot of [key], or the empty slot that ends its probe sequence
+	std::size_t probe(const Key& key) const
+	{
+		auto slot = home(key);
+		while (slots[slot].has_value() && !(slots[slot]->first == key))
+		{
+			slot = (slot + 1) & mask();
+		}
+		return slot;
+	}
+
+	void rehash(const std::size_t capacity)
+	{
+		auto old = std::exchange(slots, std::vector<std::optional<Element>>(capacity));
+		for (auto& element : old)
+		{
+			if (element.has_value())
+			{
+				slots[probe(element->first)].emplace(std::move(*element));
+			}
+		}
+	}
+
+	// Make room for one more element, the load factor is kept at 3/4 at most
+	void reserveOne()
+	{
+		if (slots.empty())
+		{
+			slots.resize(16);
+		}
+		else if ((count + 1) * 4 > slots.size() * 3)
+		{
+			rehash(slots.size() * 2);
+		}
+	}
+
+	template <bool Const>
+	class Iterator
+	{
+		friend class FlatHashMap;
+		friend class Iterator<!Const>;
+		using Slots = std::conditional_t<Const, const std::vector<std::optional<Element>>, std::vector<std::optional<Element>>>;
+		Slots* slots = nullptr;
+		std::size_t slot = 0;
+
+		Iterator(Slots* slots, const std::size_t slot) : slots(slots), slot(slot)
+		{
+			skip();
+		}
+
+		void skip()
+		{
+			while (slot < slots->size() && !(*slots)[slot].has_value())
+			{
+				slot++;
+			}
+		}
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Element;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+		using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+		Iterator() = default;
+
+		// iterator to const_iterator
+		template <bool Other, typename = std::enable_if_t<Const && !Other>>
+		Iterator(const Iterator<Other>& other) : slots(other.slots), slot(other.slot)
+		{
+		}
+
+		reference operator*() const
+		{
+			return *(*slots)[slot];
+		}
+
+		pointer operator->() const
+		{
+			return &*(*slots)[slot];
+		}
+
+		Iterator& operator++()
+		{
+			slot++;
+			skip();
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			auto copy = *this;
+			++*this;
+			return copy;
+		}
+
+		bool operator==(const Iterator& another) const
+		{
+			return slot == another.slot;
+		}
+	};
+public:
+	using value_type = Element;
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	iterator begin()
+	{
+		return { &slots, 0 };
+	}
+
+	iterator end()
+	{
+		return { &slots, slots.size() };
+	}
+
+	const_iterator begin() const
+	{
+		return { &slots, 0 };
+	}
+
+	const_iterator end() const
+	{
+		return { &slots, slots.size() };
+	}
+
+	std::size_t size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	void clear()
+	{
+		slots.clear();
+		count = 0;
+	}
+
+	iterator find(const Key& key)
+	{
+		if (count == 0)
+		{
+			return end();
+		}
+		const auto slot = probe(key);
+		return slots[slot].has_value() ? iterator(&slots, slot) : end();
+	}
+
+	const_iterator find(const Key& key) const
+	{
+		if (count == 0)
+		{
+			return end();
+		}
+		const auto slot = probe(key);
+		return slots[slot].has_value() ? const_iterator(&slots, slot) : end();
+	}
+
+	bool contains(const Key& key) const
+	{
+		return find(key) != end();
+	}
+
+	Value& operator[](const Key& key)
+	{
+		reserveOne();
+		const auto slot = probe(key);
+		if (!slots[slot].has_value())
+		{
+			slots[slot].emplace(key, Value());
+			count++;
+		}
+		return slots[slot]->second;
+	}
+
+	template <typename V>
+	void insert_or_assign(const Key& key, V&& value)
+	{
+		reserveOne();
+		if (const auto slot = probe(key); slots[slot].has_value())
+		{
+			slots[slot]->second = std::forward<V>(value);
+		}
+		else
+		{
+			slots[slot].emplace(key, std::forward<V>(value));
+			count++;
+		}
+	}
+
+	void erase(const_iterator position)
+	{
+		auto hole = position.slot;
+		slots[hole].reset();
+		count--;
+		// move every element after the hole that would no longer be found from its home slot back into the hole
+		for (auto slot = (hole + 1) & mask(); slots[slot].has_value(); slot = (slot + 1) & mask())
+		{
+			if (((slot - home(slots[slot]->first)) & mask()) >= ((slot - hole) & mask()))
+			{
+				slots[hole].emplace(std::move(*slots[slot]));
+				slots[slot].reset();
+				hole = slot;
+			}
+		}
+	}
+
+	std::size_t erase(const Key& key)
+	{
+		if (const auto itr = find(key); itr != end())
+		{
+			erase(itr);
+			return 1;
+		}
+		return 0;
+	}
+
+	// Erase every element for which [predicate] returns true, returns the number of erased elements
+	template <typename Predicate>
+	std::size_t eraseIf(Predicate&& predicate)
+	{
+		std::vector<Key> keys;
+		for (const auto& element : *this)
+		{
+			if (predicate(element))
+			{
+				keys.push_back(element.first);
+			}
+		}
+		for (const auto& key : keys)
+		{
+			erase(key);
+		}
+		return keys.size();
+	}
+};
@@ -0,0 +1,99 @@
+﻿#include "FrequencySweep.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Impedance.h"
+
+void FrequencySweepEvaluator::load(const TapeOpcode opcode, const double value, double* re, double* im) const
+{
+	const auto size = angularFrequencies.size();
+	const auto* omega = angularFrequencies.data();
+	switch (opcode)
+	{
+	case TapeOpcode::LoadResistor:
+		std::fill_n(re, size, value);
+		std::fill_n(im, size, 0.0);
+		break;
+	case TapeOpcode::LoadCapacitor:
+		std::fill_n(re, size, 0.0);
+		for (std::size_t i = 0; i < size; i++)
+		{
+			im[i] = CircuitCalculator::Impedance::Capacitor(value, omega[i]).imag();
+		}
+		break;
+	case TapeOpcode::LoadInductor:
+		std::fill_n(re, size, 0.0);
+		for (std::size_t i = 0; i < size; i++)
+		{
+			im[i] = CircuitCalculator::Impedance::Inductor(value, omega[i]).imag();
+		}
+		break;
+	default:
+		// LoadZero, sweep only calls this with the load instructions
+		std::fill_n(re, size, 0.0);
+		std::fill_n(im, size, 0.0);
+		break;
+	}
+}
+
+FrequencySweepResult FrequencySweepEvaluator::sweep(const std::span<const double> frequenciesInHz)
+{
+	const auto size = frequenciesInHz.size();
+	angularFrequencies.resize(size);
+	std::ranges::transform(frequenciesInHz, angularFrequencies.begin(), CircuitCalculator::Impedance::AngularFrequency);
+	real.resize(tape.registers() * size);
+	imaginary.resize(tape.registers() * size);
+
+	for (const auto& [opcode, destination, operand] : tape.code())
+	{
+		auto* re = real.data() + destination * size;
+		auto* im = imaginary.data() + destination * size;
+		switch (opcode)
+		{
+		case TapeOpcode::LoadResistor:
+		case TapeOpcode::LoadCapacitor:
+		case TapeOpcode::LoadInductor:
+		case TapeOpcode::LoadZero:
+			load(opcode, values[operand], re, im);
+			break;
+		case TapeOpcode::SeriesAdd:
+		{
+			const auto* otherRe = real.data() + operand * size;
+			const auto* otherIm = imaginary.data() + operand * size;
+			for (std::size_t i = 0; i < size; i++)
+			{
+				re[i] += otherRe[i];
+				im[i] += otherIm[i];
+			}
+			break;
+		}
+		case TapeOpcode::ParallelCombine:
+		{
+			const auto* otherRe = real.data() + operand * size;
+			const auto* otherIm = imaginary.data() + operand * size;
+			for (std::size_t i = 0; i < size; i++)
+			{
+				// lhs * rhs / (lhs + rhs), where a branch without impedance shorts the whole part at that frequency
+				const auto productRe = re[i] * otherRe[i] - im[i] * otherIm[i];
+				const auto productIm = re[i] * otherIm[i] + im[i] * otherRe[i];
+				const auto sumRe = re[i] + otherRe[i];
+				const auto sumIm = im[i] + otherIm[i];
+				const auto norm = sumRe * sumRe + sumIm * sumIm;
+				const auto shorted = (re[i] == 0 && im[i] == 0) || (otherRe[i] == 0 && otherIm[i] == 0);
+				re[i] = shorted ? 0.0 : (productRe * sumRe + productIm * sumIm) / norm;
+				im[i] = shorted ? 0.0 : (productIm * sumRe - productRe * sumIm) / norm;
+			}
+			break;
+		}
+		}
+	}
+
+	FrequencySweepResult result{ { frequenciesInHz.begin(), frequenciesInHz.end() }, std::vector<double>(size), std::vector<double>(size) };
+	for (std::size_t i = 0; i < size; i++)
+	{
+		result.magnitudes[i] = std::hypot(real[i], imaginary[i]);
+		result.phases[i] = std::atan2(imaginary[i], real[i]);
+	}
+	return result;
+}
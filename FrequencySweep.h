@@ -0,0 +1,54 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/FrequencySweep.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <span>
+#include <vector>
+
+#include "EvaluationTape.h"
+
+struct FrequencySweepResult
+{
+	std::vector<double> frequenciesInHz;
+	// the magnitude of the equivalent impedance at each frequency, in ohms
+	std::vector<double> magnitudes;
+	// the phase of the equivalent impedance at each frequency, in radians
+	std::vector<double> phases;
+};
+
+// Evaluates the equivalent impedance of a circuit over a whole grid of frequencies at once
+// The compiled tape only depends on the topology, so it is shared by all the frequencies and is run once per sweep instead
+// of once per frequency. Every instruction is executed for all the frequencies by a kernel that runs over structure-of-arrays
+// registers (one array for the real parts and one for the imaginary parts), those loops have no dependency between
+// iterations and are vectorized by the compiler
+class FrequencySweepEvaluator
+{
+	const EvaluationTape& tape;
+	std::span<const double> values;
+	std::vector<double> angularFrequencies;
+	// the register r holds the values of all the frequencies in [r * size, (r + 1) * size)
+	std::vector<double> real, imaginary;
+
+	void load(TapeOpcode opcode, double value, double* re, double* im) const;
+public:
+	FrequencySweepEvaluator(const EvaluationTape& tape, const std::span<const double> values) : tape(tape), values(values)
+	{
+	}
+
+	FrequencySweepResult sweep(std::span<const double> frequenciesInHz);
+};
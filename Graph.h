@@ -19,31 +19,53 @@
 #pragma once
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <ranges>
 #include <set>
 
+#include "CompactGraph.h"
+#include "FlatHashMap.h"
 #include "Node.h"
 
 // Represents the topological structure of a graph by adjacency list
 template <typename T>
 class Graph
 {
-public:
 	std::unordered_map<Node<T>, std::set<Node<T>>> adjacencyList;
+	// the CSR snapshot of [adjacencyList] handed out by [compact], built on the first call after the graph changes and shared
+	// by the copies of the graph
+	std::shared_ptr<const CompactGraph<T>> snapshot;
+public:
+	Graph() = default;
+
+	// Take over an adjacency list that is already built, every successor must be a key of [adjacencyList] as well
+	explicit Graph(std::unordered_map<Node<T>, std::set<Node<T>>> adjacencyList) : adjacencyList(std::move(adjacencyList))
+	{
+	}
+
+	// The successors of every node, the list can only be changed through [addEdge], which keeps [compact] up to date
+	const std::unordered_map<Node<T>, std::set<Node<T>>>& adjacency() const
+	{
+		return adjacencyList;
+	}
 
 	void addEdge(const Node<T>& from, const Node<T>& to)
 	{
-		if (!adjacencyList.contains(from))
-		{
-			adjacencyList[from] = std::move(std::set<Node<T>>());
-		}
 		adjacencyList[from].insert(to);
-		if (!adjacencyList.contains(to))
+		adjacencyList.try_emplace(to);
+		snapshot.reset();
+	}
+
+	// The CSR snapshot of the graph, which is built once and reused until the next addEdge
+	const CompactGraph<T>& compact()
+	{
+		if (snapshot == nullptr)
 		{
-			adjacencyList[to] = std::move(std::set<Node<T>>());
+			snapshot = std::make_shared<const CompactGraph<T>>(*this);
 		}
+		return *snapshot;
 	}
 
 	std::set<Node<T>> vertices()
@@ -57,41 +79,23 @@ public:
 	}
 
 	// Get all non trivial paths (i.e., those who contains more than one intermediate node) between start and node
+	// Prefer CompactGraph::forEachNonTrivialPath when the paths can be consumed one by one, this function materializes all of them
 	std::vector<std::vector<Node<T>>> nonTrivialPaths(const Node<T>& start, const Node<T>& end)
 	{
-		std::set<Node<T>> visited;
-		std::vector<Node<T>> currentPath;
 		std::vector<std::vector<Node<T>>> allPaths;
-
-		std::function<void(const Node<T>&, const Node<T>&)> helper;
-		helper = [&visited, &currentPath, &allPaths, this, &helper, &start](const Node<T>& s, const Node<T>& e)
+		const auto& compactGraph = compact();
+		const auto s = compactGraph.denseId(start);
+		const auto e = compactGraph.denseId(end);
+		if (s == -1 || e == -1)
 		{
-			if (visited.contains(s))
-			{
-				return;
-			}
-			visited.insert(s);
-			currentPath.push_back(s);
-			if (s == e)
-			{
-				std::vector<Node<T>> path;
-				std::ranges::copy_if(currentPath, std::inserter(path, path.begin()), [&e, &start](const Node<T>& node) { return node != start && node != e; });
-				if (!path.empty())
-				{
-					allPaths.push_back(path);
-				}
-				visited.erase(s);
-				currentPath.pop_back();
-				return;
-			}
-			for (const auto& successor : adjacencyList[s])
+			return allPaths;
+		}
+		compactGraph.forEachNonTrivialPath(s, e, [&allPaths, &compactGraph](const std::span<const int> path)
 			{
-				helper(successor, e);
-			}
-			currentPath.pop_back();
-			visited.erase(s);
-		};
-		helper(start, end);
+				auto& nodes = allPaths.emplace_back();
+				nodes.reserve(path.size());
+				std::ranges::transform(path, std::back_inserter(nodes), [&compactGraph](const int vertex) { return compactGraph.node(vertex); });
+			});
 		return allPaths;
 	}
 
@@ -124,7 +128,7 @@ public:
 		{
 			auto n = stack.back();
 			stack.pop_back();
-			for (const auto& successor : adjacencyList[n])
+			for (const auto& successor : adjacencyList.at(n))
 			{
 				if (!visited.contains(successor))
 				{
@@ -144,4 +148,15 @@ struct std::hash<Node<T>>
 	{
 		return node.index;
 	}
+};
+
+// An edge or the two end points of a path
+template<typename T>
+struct std::hash<std::pair<Node<T>, Node<T>>>
+{
+	std::size_t operator()(const std::pair<Node<T>, Node<T>>& pair) const
+	{
+		// the hash of Node<T> is the bare index, a plain XOR of two of them maps (a, b) and (b, a) to the same bucket
+		return FlatHash<std::pair<Node<T>, Node<T>>>{}(pair);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/Impedance.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <complex>
+#include <numbers>
+
+// The numeric counterpart of the impedance strings, the scripts express resistance in ohms, capacitance in microfarads
+// and inductance in millihenries
+namespace CircuitCalculator::Impedance
+{
+	inline double AngularFrequency(const double frequencyInHz)
+	{
+		return 2 * std::numbers::pi * frequencyInHz;
+	}
+
+	inline std::complex<double> Resistor(const double resistanceInO)
+	{
+		return { resistanceInO, 0 };
+	}
+
+	inline std::complex<double> Capacitor(const double capacitanceInF, const double angularFrequency)
+	{
+		return { 0, -1 / (angularFrequency * capacitanceInF) * 1E06 };
+	}
+
+	inline std::complex<double> Inductor(const double inductanceInH, const double angularFrequency)
+	{
+		return { 0, angularFrequency * inductanceInH * 1E-3 };
+	}
+
+	// A branch without impedance shorts the whole parallel part, which is checked explicitly since 0 * 0 / (0 + 0) is NaN
+	inline std::complex<double> Parallel(const std::complex<double>& lhs, const std::complex<double>& rhs)
+	{
+		return lhs == std::complex<double>() || rhs == std::complex<double>() ? std::complex<double>() : lhs * rhs / (lhs + rhs);
+	}
+}
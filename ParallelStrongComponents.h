@@ -0,0 +1,368 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/ParallelStrongComponents.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "Node.h"
+#include "StrongComponents.h"
+#include "WorkStealingThreadPool.h"
+
+// Finds the same strong components as StrongComponents, but on the workers of a thread pool, for the netlists that are
+// large enough for a single linear pass to become the bottleneck
+//
+// The vertices without any incoming or outgoing edge are trimmed away first, they are strong components on their own and
+// the peeling cascades to the vertices that become trimmable in turn. The rest is split by the forward-backward algorithm
+// of Fleischer, Hendrickson and Pinar, "On Identifying Strongly Connected Components in Parallel" (2000): the vertices
+// that are both reachable from a pivot and reaching it form the strong component of the pivot, and every other strong
+// component lies entirely in one of the three remaining parts (forward only, backward only, neither), which are split
+// independently by their own tasks. Each part is marked by a color of its own, so the tasks never touch the same vertex.
+// Once a part is small enough, it is handed to the sequential Tarjan of the worker instead
+template <typename T>
+class ParallelStrongComponents
+{
+	// parts below this size are cheaper to finish with Tarjan than to split any further
+	static constexpr std::size_t SequentialThreshold = 4096;
+	// the number of vertices every trimming task starts from
+	static constexpr int TrimChunkSize = 16384;
+	// the color of the vertices whose strong component has been found
+	static constexpr int Done = -1;
+
+	const CompactGraph<T>& graph;
+	WorkStealingThreadPool& pool;
+	// the predecessors of the vertex v are stored in reverseTargets[reverseOffsets[v], reverseOffsets[v + 1])
+	std::vector<int> reverseOffsets;
+	std::vector<int> reverseTargets;
+	std::vector<std::atomic<int>> colors;
+	std::atomic<int> nextColor;
+	std::vector<std::unique_ptr<StrongComponents<T>>> tarjans;
+	std::mutex resultMutex;
+	std::vector<std::vector<int>> result;
+
+	std::span<const int> predecessors(const int vertex) const
+	{
+		return { reverseTargets.data() + reverseOffsets[vertex], reverseTargets.data() + reverseOffsets[vertex + 1] };
+	}
+
+	void emit(std::vector<std::vector<int>>&& components)
+	{
+		std::lock_guard lock(resultMutex);
+		std::ranges::move(components, std::back_inserter(result));
+	}
+
+	template <typename Fn>
+	void forEachChunk(Fn fn)
+	{
+		for (int begin = 0; begin < graph.vertexCount(); begin += TrimChunkSize)
+		{
+			const auto end = std::min(begin + TrimChunkSize, graph.vertexCount());
+			pool.submit([fn, begin, end] { fn(begin, end); });
+		}
+		pool.wait();
+	}
+
+	void transpose()
+	{
+		const auto size = graph.vertexCount();
+		std::vector<std::atomic<int>> cursors(size + 1);
+		forEachChunk([this, &cursors](const int begin, const int end)
+			{
+				for (int vertex = begin; vertex < end; vertex++)
+				{
+					for (const int successor : graph.successors(vertex))
+					{
+						cursors[successor + 1].fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			});
+		reverseOffsets.assign(size + 1, 0);
+		for (int vertex = 0; vertex < size; vertex++)
+		{
+			reverseOffsets[vertex + 1] = reverseOffsets[vertex] + cursors[vertex + 1].load(std::memory_order_relaxed);
+			cursors[vertex].store(reverseOffsets[vertex], std::memory_order_relaxed);
+		}
+		reverseTargets.resize(graph.edgeCount());
+		forEachChunk([this, &cursors](const int begin, const int end)
+			{
+				for (int vertex = begin; vertex < end; vertex++)
+				{
+					for (const int successor : graph.successors(vertex))
+					{
+						reverseTargets[cursors[successor].fetch_add(1, std::memory_order_relaxed)] = vertex;
+					}
+				}
+			});
+	}
+
+	void trim()
+	{
+		const auto size = graph.vertexCount();
+		std::vector<std::atomic<int>> inDegrees(size), outDegrees(size);
+		for (int vertex = 0; vertex < size; vertex++)
+		{
+			inDegrees[vertex].store(static_cast<int>(predecessors(vertex).size()), std::memory_order_relaxed);
+			outDegrees[vertex].store(static_cast<int>(graph.successors(vertex).size()), std::memory_order_relaxed);
+		}
+		forEachChunk([this, &inDegrees, &outDegrees](const int begin, const int end)
+			{
+				// whoever turns the color of a vertex into Done owns it, so every vertex is peeled exactly once
+				const auto claim = [this](const int vertex)
+				{
+					auto expected = 0;
+					return colors[vertex].compare_exchange_strong(expected, Done, std::memory_order_relaxed);
+				};
+				std::vector<std::vector<int>> singletons;
+				std::vector<int> stack;
+				for (int vertex = begin; vertex < end; vertex++)
+				{
+					if ((inDegrees[vertex].load(std::memory_order_relaxed) == 0 || outDegrees[vertex].load(std::memory_order_relaxed) == 0) && claim(vertex))
+					{
+						stack.push_back(vertex);
+					}
+					while (!stack.empty())
+					{
+						const auto v = stack.back();
+						stack.pop_back();
+						singletons.push_back({ v });
+						for (const int successor : graph.successors(v))
+						{
+							if (inDegrees[successor].fetch_sub(1, std::memory_order_relaxed) == 1 && claim(successor))
+							{
+								stack.push_back(successor);
+							}
+						}
+						for (const int predecessor : predecessors(v))
+						{
+							if (outDegrees[predecessor].fetch_sub(1, std::memory_order_relaxed) == 1 && claim(predecessor))
+							{
+								stack.push_back(predecessor);
+							}
+						}
+					}
+				}
+				emit(std::move(singletons));
+			});
+	}
+
+	// Mark everything of [color] that is reachable from [pivot] along [edges] with [mark], or everything of [color] and
+	// [alternative] with [mark] and [alternativeMark] respectively
+	template <typename Edges>
+	void reach(const int pivot, const int color, const int mark, const int alternative, const int alternativeMark, Edges edges)
+	{
+		std::vector<int> stack{ pivot };
+		while (!stack.empty())
+		{
+			const auto vertex = stack.back();
+			stack.pop_back();
+			for (const int next : edges(vertex))
+			{
+				const auto current = colors[next].load(std::memory_order_relaxed);
+				if (current == color || current == alternative)
+				{
+					colors[next].store(current == color ? mark : alternativeMark, std::memory_order_relaxed);
+					stack.push_back(next);
+				}
+			}
+		}
+	}
+
+	void split(std::vector<int> vertices, const int color)
+	{
+		if (vertices.size() <= SequentialThreshold)
+		{
+			auto& tarjan = tarjans[pool.workerIndex()];
+			if (tarjan == nullptr)
+			{
+				tarjan = std::make_unique<StrongComponents<T>>(graph);
+			}
+			// every part is a union of whole strong components, so the sub graph it induces has the same ones
+			auto components = tarjan->inducedStrongComponents(vertices);
+			for (const int vertex : vertices)
+			{
+				colors[vertex].store(Done, std::memory_order_relaxed);
+			}
+			emit(std::move(components));
+			return;
+		}
+
+		const auto forward = nextColor.fetch_add(2, std::memory_order_relaxed);
+		// a pivot at random splits a long chain of components near its middle on average, whereas always taking the first
+		// vertex may peel off a single component per split
+		const auto pivot = vertices[std::minstd_rand(forward)() % vertices.size()];
+		const auto backward = forward + 1;
+		colors[pivot].store(forward, std::memory_order_relaxed);
+		reach(pivot, color, forward, color, forward, [this](const int vertex) { return graph.successors(vertex); });
+		colors[pivot].store(Done, std::memory_order_relaxed);
+		reach(pivot, color, backward, forward, Done, [this](const int vertex) { return predecessors(vertex); });
+
+		std::vector<int> component, forwardOnly, backwardOnly, rest;
+		for (const int vertex : vertices)
+		{
+			const auto current = colors[vertex].load(std::memory_order_relaxed);
+			if (current == Done)
+			{
+				component.push_back(vertex);
+			}
+			else if (current == forward)
+			{
+				forwardOnly.push_back(vertex);
+			}
+			else if (current == backward)
+			{
+				backwardOnly.push_back(vertex);
+			}
+			else
+			{
+				rest.push_back(vertex);
+			}
+		}
+		std::vector<std::vector<int>> components;
+		components.push_back(std::move(component));
+		emit(std::move(components));
+		for (auto [part, partColor] : { std::pair{ &forwardOnly, forward }, std::pair{ &backwardOnly, backward }, std::pair{ &rest, color } })
+		{
+			if (!part->empty())
+			{
+				pool.submit([this, part = std::move(*part), partColor]() mutable { split(std::move(part), partColor); });
+			}
+		}
+	}
+	// Order [components] so that every edge between two of them goes from a later one to an earlier one, by Kahn's algorithm
+	// on the condensation run from its sinks, which takes the components without successors in their given order
+	std::vector<std::vector<int>> reverseTopologicalOrder(std::vector<std::vector<int>> components) const
+	{
+		const auto count = static_cast<int>(components.size());
+		std::vector<int> componentOf(graph.vertexCount());
+		for (int component = 0; component < count; component++)
+		{
+			for (const int vertex : components[component])
+			{
+				componentOf[vertex] = component;
+			}
+		}
+		// the number of edges, duplicates included, that leave every component
+		std::vector<int> outDegrees(count);
+		std::vector<int> order;
+		order.reserve(count);
+		for (int component = 0; component < count; component++)
+		{
+			for (const int vertex : components[component])
+			{
+				for (const int successor : graph.successors(vertex))
+				{
+					outDegrees[component] += componentOf[successor] != component;
+				}
+			}
+			if (outDegrees[component] == 0)
+			{
+				order.push_back(component);
+			}
+		}
+		for (std::size_t next = 0; next < order.size(); next++)
+		{
+			const auto component = order[next];
+			for (const int vertex : components[component])
+			{
+				for (const int predecessor : predecessors(vertex))
+				{
+					if (const auto source = componentOf[predecessor]; source != component && --outDegrees[source] == 0)
+					{
+						order.push_back(source);
+					}
+				}
+			}
+		}
+		std::vector<std::vector<int>> ordered;
+		ordered.reserve(count);
+		for (const auto component : order)
+		{
+			ordered.push_back(std::move(components[component]));
+		}
+		return ordered;
+	}
+public:
+	ParallelStrongComponents(const CompactGraph<T>& graph, WorkStealingThreadPool& pool)
+		: graph(graph), pool(pool), colors(graph.vertexCount()), nextColor(1), tarjans(pool.size())
+	{
+	}
+
+	// The strong components expressed in the dense ids of [graph], each of them is sorted ascending. Like those of
+	// StrongComponents, the components are in a reverse topological order of the condensation, every edge between two of
+	// them goes from a later one to an earlier one, but the order among the independent ones is not necessarily the one
+	// Tarjan's algorithm would produce. It does not depend on the order in which the workers find the components
+	// With a single worker, or a graph that would go to Tarjan as a single part anyway, there is nothing to split, and the
+	// transposition, the trimming and the ordering would only add to a single pass of StrongComponents, which is used instead
+	std::vector<std::vector<int>> denseStrongComponents()
+	{
+		if (pool.size() == 1 || static_cast<std::size_t>(graph.vertexCount()) <= SequentialThreshold)
+		{
+			return StrongComponents(graph).denseStrongComponents();
+		}
+		result.clear();
+		for (auto& color : colors)
+		{
+			color.store(0, std::memory_order_relaxed);
+		}
+		transpose();
+		trim();
+
+		std::vector<int> remaining;
+		for (int vertex = 0; vertex < graph.vertexCount(); vertex++)
+		{
+			if (colors[vertex].load(std::memory_order_relaxed) != Done)
+			{
+				remaining.push_back(vertex);
+			}
+		}
+		if (!remaining.empty())
+		{
+			pool.submit([this, remaining = std::move(remaining)]() mutable { split(std::move(remaining), 0); });
+			pool.wait();
+		}
+
+		for (auto& component : result)
+		{
+			std::ranges::sort(component);
+		}
+		// sorting by the least vertex first makes the order below independent of the scheduling
+		std::ranges::sort(result, [](const std::vector<int>& lhs, const std::vector<int>& rhs) { return lhs.front() < rhs.front(); });
+		return reverseTopologicalOrder(std::move(result));
+	}
+
+	std::vector<std::set<Node<T>>> strongComponents()
+	{
+		std::vector<std::set<Node<T>>> components;
+		for (const auto& component : denseStrongComponents())
+		{
+			std::set<Node<T>> set;
+			for (const int vertex : component)
+			{
+				set.insert(graph.node(vertex));
+			}
+			components.push_back(set);
+		}
+		return components;
+	}
+};
@@ -0,0 +1,119 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/PathPool.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A path stored in a PathPool, [offset] is the position of its last vertex in the pool
+struct PathHandle
+{
+	std::int32_t offset;
+	std::int32_t length;
+};
+
+// Stores many paths of vertex ids in a few contiguous int32 arrays
+// The pool is a trie in which every entry holds a vertex and the position of the entry before it on the path, so the paths that
+// begin the same way share the entries of their common prefix. Paths enumerated by a depth-first search, which differ from the
+// previous one only after the point it backtracked to, take as little as one new entry each. A path is referred to by a handle
+// of two ints instead of a vector of its own
+class PathPool
+{
+	std::vector<std::int32_t> vertices;
+	// the position of the previous entry on the path, -1 for the first vertex
+	std::vector<std::int32_t> parents;
+	// the first vertex of the path through each entry, so that both ends of a path are known without walking it
+	std::vector<std::int32_t> firsts;
+	// the last path that was added and the positions of its entries, new paths share their common prefix with it
+	std::vector<std::int32_t> lastPath;
+	std::vector<std::int32_t> lastEntries;
+public:
+	PathHandle add(const std::span<const int> path)
+	{
+		std::size_t common = 0;
+		while (common < path.size() && common < lastPath.size() && lastPath[common] == path[common])
+		{
+			common++;
+		}
+		lastPath.resize(common);
+		lastEntries.resize(common);
+		for (auto i = common; i < path.size(); i++)
+		{
+			const auto entry = static_cast<std::int32_t>(vertices.size());
+			vertices.push_back(path[i]);
+			parents.push_back(i == 0 ? -1 : lastEntries.back());
+			firsts.push_back(i == 0 ? path[i] : firsts[lastEntries.back()]);
+			lastPath.push_back(path[i]);
+			lastEntries.push_back(entry);
+		}
+		return { path.empty() ? -1 : lastEntries.back(), static_cast<std::int32_t>(path.size()) };
+	}
+
+	int front(const PathHandle path) const
+	{
+		return firsts[path.offset];
+	}
+
+	int back(const PathHandle path) const
+	{
+		return vertices[path.offset];
+	}
+
+	// Copy the vertices of [path] in order into [out], which is resized to fit
+	void copy(const PathHandle path, std::vector<int>& out) const
+	{
+		out.resize(path.length);
+		for (auto entry = path.offset, i = path.length - 1; i >= 0; entry = parents[entry], i--)
+		{
+			out[i] = vertices[entry];
+		}
+	}
+
+	std::vector<int> path(const PathHandle path) const
+	{
+		std::vector<int> out;
+		copy(path, out);
+		return out;
+	}
+
+	// Call [fn] on every vertex of [path], from the last one to the first one
+	template <typename Fn>
+	void forEachBackward(const PathHandle path, Fn&& fn) const
+	{
+		for (auto entry = path.offset, i = 0; i < path.length; entry = parents[entry], i++)
+		{
+			fn(vertices[entry]);
+		}
+	}
+
+	// The number of entries, which is also the number of int32 stored in each of the arrays
+	std::size_t size() const
+	{
+		return vertices.size();
+	}
+
+	void clear()
+	{
+		vertices.clear();
+		parents.clear();
+		firsts.clear();
+		lastPath.clear();
+		lastEntries.clear();
+	}
+};
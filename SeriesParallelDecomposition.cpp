@@ -0,0 +1,250 @@
+﻿#include "SeriesParallelDecomposition.h"
+
+#include <algorithm>
+#include <numeric>
+#include <ranges>
+#include <set>
+
+#include "CircuitExceptions.h"
+
+std::uint64_t SeriesParallelDecomposer::key(const int from, const int to)
+{
+	return static_cast<std::uint64_t>(std::min(from, to)) << 32 | static_cast<std::uint32_t>(std::max(from, to));
+}
+
+int SeriesParallelDecomposer::makeNode(const SeriesParallelNodeKind kind, const int unit, std::vector<int> children)
+{
+	const auto id = static_cast<int>(nodes.size());
+	for (const auto child : children)
+	{
+		nodes[child].parent = id;
+	}
+	nodes.push_back({ kind, unit, -1, std::move(children) });
+	return id;
+}
+
+void SeriesParallelDecomposer::addEdge(const int from, const int to, const int node)
+{
+	// self loops, i.e., units whose both terminals are wired together, are kept as they are and end up in the diagnostic
+	if (from != to)
+	{
+		if (const auto itr = edgeBetween.find(key(from, to)); itr != edgeBetween.end())
+		{
+			auto& existing = edges[itr->second];
+			existing.node = makeNode(SeriesParallelNodeKind::Parallel, -1, { existing.node, node });
+			return;
+		}
+		edgeBetween.emplace(key(from, to), static_cast<int>(edges.size()));
+	}
+	incidentEdges[from].insert(static_cast<int>(edges.size()));
+	incidentEdges[to].insert(static_cast<int>(edges.size()));
+	edges.push_back({ from, to, node, true });
+}
+
+void SeriesParallelDecomposer::removeEdge(const int edge)
+{
+	auto& e = edges[edge];
+	e.alive = false;
+	incidentEdges[e.from].erase(edge);
+	incidentEdges[e.to].erase(edge);
+	edgeBetween.erase(key(e.from, e.to));
+}
+
+void SeriesParallelDecomposer::reduceSeries(const int net)
+{
+	if (incidentEdges[net].size() != 2)
+	{
+		return;
+	}
+	auto itr = incidentEdges[net].begin();
+	auto first = *itr++;
+	auto second = *itr;
+	if (edges[first].from == edges[first].to || edges[second].from == edges[second].to)
+	{
+		return;
+	}
+	// keep the direction of the current, the edge that flows into [net] goes first
+	if (edges[first].to != net)
+	{
+		std::swap(first, second);
+	}
+	const auto from = edges[first].from == net ? edges[first].to : edges[first].from;
+	const auto to = edges[second].from == net ? edges[second].to : edges[second].from;
+	removeEdge(first);
+	removeEdge(second);
+	addEdge(from, to, makeNode(SeriesParallelNodeKind::Series, -1, { edges[first].node, edges[second].node }));
+	// the new edge may have been merged into an existing one, which lowers the degree of both ends
+	worklist.push_back(from);
+	worklist.push_back(to);
+}
+
+SeriesParallelTree SeriesParallelDecomposer::compact(const int root, const int power) const
+{
+	SeriesParallelTree tree;
+	tree.power = power;
+	std::vector<int> newIds(nodes.size(), -1);
+	// the flattened children of the nodes that are about to be merged into a parent of the same kind
+	std::vector<std::vector<int>> pending(nodes.size());
+	std::vector<std::pair<int, bool>> stack{ { root, false } };
+	while (!stack.empty())
+	{
+		const auto [node, expanded] = stack.back();
+		stack.pop_back();
+		const auto& current = nodes[node];
+		if (!expanded)
+		{
+			stack.emplace_back(node, true);
+			for (const auto child : current.children | std::views::reverse)
+			{
+				stack.emplace_back(child, false);
+			}
+			continue;
+		}
+
+		std::vector<int> children;
+		for (const auto child : current.children)
+		{
+			if (nodes[child].kind == current.kind)
+			{
+				std::ranges::move(pending[child], std::back_inserter(children));
+				pending[child].clear();
+			}
+			else
+			{
+				children.push_back(newIds[child]);
+			}
+		}
+		if (node != root && current.kind != SeriesParallelNodeKind::Unit && nodes[current.parent].kind == current.kind)
+		{
+			pending[node] = std::move(children);
+			continue;
+		}
+		newIds[node] = static_cast<int>(tree.nodes.size());
+		for (const auto child : children)
+		{
+			tree.nodes[child].parent = newIds[node];
+		}
+		tree.nodes.push_back({ current.kind, current.unit, -1, std::move(children) });
+	}
+	return tree;
+}
+
+SeriesParallelTree SeriesParallelDecomposer::decompose()
+{
+	const auto size = graph.vertexCount();
+	auto power = -1;
+	for (int vertex = 0; vertex < size; vertex++)
+	{
+		if (graph.payload(vertex) == CircuitScriptGraphNodeKind::Power)
+		{
+			power = vertex;
+			break;
+		}
+	}
+	if (power == -1)
+	{
+		throw NoPowerSupplyFoundException();
+	}
+
+	// the terminal 2v is the input of the unit v, and 2v + 1 is its output, every edge of the graph wires an output to an input
+	std::vector<int> terminals(2 * static_cast<std::size_t>(size));
+	std::iota(terminals.begin(), terminals.end(), 0);
+	const auto find = [&terminals](int terminal)
+	{
+		while (terminals[terminal] != terminal)
+		{
+			terminal = terminals[terminal] = terminals[terminals[terminal]];
+		}
+		return terminal;
+	};
+	for (int vertex = 0; vertex < size; vertex++)
+	{
+		for (const auto successor : graph.successors(vertex))
+		{
+			terminals[find(2 * vertex + 1)] = find(2 * successor);
+		}
+	}
+
+	std::vector<int> nets(terminals.size(), -1);
+	auto netCount = 0;
+	const auto net = [&nets, &netCount, &find](const int terminal)
+	{
+		const auto representative = find(terminal);
+		if (nets[representative] == -1)
+		{
+			nets[representative] = netCount++;
+		}
+		return nets[representative];
+	};
+	std::vector<std::pair<int, int>> unitNets;
+	unitNets.reserve(size);
+	for (int vertex = 0; vertex < size; vertex++)
+	{
+		unitNets.emplace_back(net(2 * vertex), net(2 * vertex + 1));
+	}
+
+	nodes.clear();
+	edges.clear();
+	edgeBetween.clear();
+	worklist.clear();
+	incidentEdges.assign(netCount, {});
+	// the current leaves the power supply from its output and returns to its input
+	const auto source = unitNets[power].second;
+	const auto sink = unitNets[power].first;
+	for (int vertex = 0; vertex < size; vertex++)
+	{
+		if (vertex != power)
+		{
+			addEdge(unitNets[vertex].first, unitNets[vertex].second, makeNode(SeriesParallelNodeKind::Unit, vertex, {}));
+		}
+	}
+
+	for (int n = 0; n < netCount; n++)
+	{
+		worklist.push_back(n);
+	}
+	while (!worklist.empty())
+	{
+		const auto n = worklist.back();
+		worklist.pop_back();
+		if (n != source && n != sink)
+		{
+			reduceSeries(n);
+		}
+	}
+
+	std::vector<int> remaining;
+	for (int edge = 0; edge < static_cast<int>(edges.size()); edge++)
+	{
+		if (edges[edge].alive)
+		{
+			remaining.push_back(edge);
+		}
+	}
+	if (source != sink && remaining.size() == 1 && edgeBetween.contains(key(source, sink)))
+	{
+		return compact(edges[remaining.front()].node, power);
+	}
+
+	// report the units of every edge that is left, except the one that has already been reduced between the two terminals
+	std::set<Node<CircuitScriptGraphNodeKind>> irreducible;
+	for (const auto edge : remaining)
+	{
+		if (remaining.size() > 1 && key(edges[edge].from, edges[edge].to) == key(source, sink) && source != sink)
+		{
+			continue;
+		}
+		std::vector<int> stack{ edges[edge].node };
+		while (!stack.empty())
+		{
+			const auto node = stack.back();
+			stack.pop_back();
+			if (nodes[node].kind == SeriesParallelNodeKind::Unit)
+			{
+				irreducible.insert(graph.node(nodes[node].unit));
+			}
+			std::ranges::copy(nodes[node].children, std::back_inserter(stack));
+		}
+	}
+	throw NonSeriesParallelCircuitException(irreducible);
+}
@@ -0,0 +1,109 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/SeriesParallelDecomposition.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "CircuitScriptGraphNode.h"
+#include "CompactGraph.h"
+
+enum class SeriesParallelNodeKind
+{
+	Unit,
+	Series,
+	Parallel
+};
+
+struct SeriesParallelNode
+{
+	SeriesParallelNodeKind kind;
+	// the dense id of the unit in the CompactGraph that was decomposed, -1 for the Series and Parallel nodes
+	int unit;
+	// -1 for the root
+	int parent;
+	// in the order of the current flow for Series nodes, nested nodes of the same kind are always flattened into their parent
+	std::vector<int> children;
+};
+
+// The decomposition tree of the circuit, with the power supply taken out, the remaining network is a two-terminal
+// series-parallel graph between the two sides of the power supply
+struct SeriesParallelTree
+{
+	// every node comes after all of its children, and the root is the last one
+	std::vector<SeriesParallelNode> nodes;
+	// the dense id of the power unit
+	int power = -1;
+
+	int root() const
+	{
+		return static_cast<int>(nodes.size()) - 1;
+	}
+};
+
+// Recognizes two-terminal series-parallel circuits and builds their decomposition tree in linear time, in the spirit of
+// Valdes, Tarjan and Lawler, "The Recognition of Series Parallel Digraphs" (1982)
+// 
+// The units of the circuit are the vertices of the graph, while electrically they are the edges, so every unit is first
+// turned into an edge between the two nets (i.e., the sets of terminals joined by wires) it connects. An edge u -> v in the
+// graph joins the output terminal of u and the input terminal of v into the same net. Then the network is reduced by two
+// rules until only a single edge is left between the terminals of the power supply:
+//   - parallel reduction: two edges connecting the same pair of nets are merged into a Parallel node
+//   - series reduction: a net other than the two terminals that joins exactly two edges is contracted into a Series node
+// Every reduction removes one edge, and only the nets touched by a reduction are revisited, hence the O(V+E) bound.
+// Whatever is left after the reductions is not series-parallel, e.g., the bridge of a Wheatstone bridge, and is reported
+// through NonSeriesParallelCircuitException
+class SeriesParallelDecomposer
+{
+	struct Edge
+	{
+		int from;
+		int to;
+		int node;
+		bool alive;
+	};
+
+	const CompactGraph<CircuitScriptGraphNodeKind>& graph;
+	// the tree under construction, it is a binary tree until [compact] flattens it
+	std::vector<SeriesParallelNode> nodes;
+	std::vector<Edge> edges;
+	std::vector<std::unordered_set<int>> incidentEdges;
+	// the live edge between each unordered pair of nets, parallel edges are merged as soon as they appear
+	std::unordered_map<std::uint64_t, int> edgeBetween;
+	std::vector<int> worklist;
+
+	static std::uint64_t key(int from, int to);
+
+	int makeNode(SeriesParallelNodeKind kind, int unit, std::vector<int> children);
+
+	void addEdge(int from, int to, int node);
+
+	void removeEdge(int edge);
+
+	void reduceSeries(int net);
+
+	SeriesParallelTree compact(int root, int power) const;
+public:
+	explicit SeriesParallelDecomposer(const CompactGraph<CircuitScriptGraphNodeKind>& graph) : graph(graph)
+	{
+	}
+
+	SeriesParallelTree decompose();
+};
@@ -17,67 +17,245 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
+#include <algorithm>
+#include <set>
+#include <span>
+#include <utility>
+#include <vector>
 
+#include "CompactGraph.h"
 #include "Node.h"
-#include "Graph.h"
+
+// The condensation of a graph, i.e., the DAG obtained by contracting every strong component into a single vertex
+struct StrongComponentCondensation
+{
+	// the component id of every vertex, indexed by dense id
+	std::vector<int> componentOf;
+	// the vertices of every component, sorted ascending, the components are in the order Tarjan's algorithm completes them,
+	// which is a reverse topological order of the DAG, i.e., every edge goes from a higher id to a lower one
+	std::vector<std::vector<int>> components;
+	// the successors of the component c are stored in targets[offsets[c], offsets[c + 1]), without duplicates
+	std::vector<int> offsets;
+	std::vector<int> targets;
+
+	int componentCount() const
+	{
+		return static_cast<int>(components.size());
+	}
+
+	std::span<const int> successors(const int component) const
+	{
+		return { targets.data() + offsets[component], targets.data() + offsets[component + 1] };
+	}
+};
 
 // Tarjan's Algorithm
+// Runs on the sub graph of [graph] where all the vertices below [leastVertex] are dropped
+// The depth-first search keeps its own stack of frames instead of recursing, so long chains of units cannot overflow the
+// call stack, and whether a vertex is on the Tarjan stack is kept in a flag per vertex so that the test is O(1)
 template <typename T>
 class StrongComponents
 {
-	Graph<T> graph;
+	struct Frame
+	{
+		int vertex;
+		// the position of the next successor to be explored
+		int cursor;
+	};
+
+	const CompactGraph<T>& graph;
+	int leastVertex;
 	int index;
-	std::unordered_map<Node<T>, int> indexMap, lowLinkMap;
-	std::vector<Node<T>> stack;
-	std::vector<std::set<Node<T>>> result;
+	std::vector<int> indexMap, lowLinkMap;
+	std::vector<bool> onStack;
+	// when [scoped] is set, the search is restricted to the vertices flagged in [inScope] instead of those above [leastVertex]
+	std::vector<bool> inScope;
+	bool scoped = false;
+	std::vector<int> stack;
+	std::vector<Frame> frames;
+	std::vector<int> visited;
+	std::vector<std::vector<int>> result;
 
-	void helper(const Node<T>& node)
+	void discover(const int node)
 	{
+		visited.push_back(node);
 		indexMap[node] = index;
 		lowLinkMap[node] = index;
 		index++;
 		stack.push_back(node);
-		for (const Node<T>& successor : graph.adjacencyList[node])
+		onStack[node] = true;
+		frames.push_back({ node, 0 });
+	}
+
+	void helper(const int root)
+	{
+		discover(root);
+		while (!frames.empty())
 		{
-			if (!indexMap.contains(successor))
+			const auto node = frames.back().vertex;
+			const auto successors = graph.successors(node);
+			if (frames.back().cursor < static_cast<int>(successors.size()))
+			{
+				const auto successor = successors[frames.back().cursor++];
+				if (scoped ? !inScope[successor] : successor < leastVertex)
+				{
+					continue;
+				}
+				if (indexMap[successor] == -1)
+				{
+					discover(successor);
+				}
+				else if (onStack[successor])
+				{
+					lowLinkMap[node] = std::min(lowLinkMap[node], indexMap[successor]);
+				}
+				continue;
+			}
+
+			// all the successors are done, which is where the recursive version returns to its caller
+			frames.pop_back();
+			if (!frames.empty())
 			{
-				helper(successor);
-				lowLinkMap[node] = std::min(lowLinkMap[node], lowLinkMap[successor]);
+				auto& parent = lowLinkMap[frames.back().vertex];
+				parent = std::min(parent, lowLinkMap[node]);
 			}
-			else if (std::ranges::find(stack, successor) != stack.end())
+			if (lowLinkMap[node] == indexMap[node])
 			{
-				lowLinkMap[node] = std::min(lowLinkMap[node], indexMap[successor]);
+				std::vector<int> res;
+				int w;
+				do
+				{
+					w = stack.back();
+					stack.pop_back();
+					onStack[w] = false;
+					res.push_back(w);
+				} while (w != node);
+				std::ranges::sort(res);
+				result.push_back(res);
 			}
 		}
+	}
+	// Forget the indices of the vertices visited so far, so that the same instance can run another search
+	void reset()
+	{
+		for (const int v : visited)
+		{
+			indexMap[v] = -1;
+			lowLinkMap[v] = -1;
+		}
+		visited.clear();
+		index = 0;
+	}
+public:
+	explicit StrongComponents(const CompactGraph<T>& graph, const int leastVertex = 0)
+		: graph(graph), leastVertex(leastVertex), index(0), indexMap(graph.vertexCount(), -1), lowLinkMap(graph.vertexCount(), -1),
+		  onStack(graph.vertexCount())
+	{
+	}
 
-		if (lowLinkMap[node] == indexMap[node])
+	// The strong components expressed in the dense ids of [graph], each of them is sorted ascending
+	std::vector<std::vector<int>> denseStrongComponents()
+	{
+		for (int vertex = leastVertex; vertex < graph.vertexCount(); vertex++)
 		{
-			std::set<Node<T>> res;
-			Node<T> w = stack.back();
-			do
+			if (indexMap[vertex] == -1)
 			{
-				w = stack.back();
-				stack.pop_back();
-				res.insert(w);
-			} while (w.index != node.index);
-			result.push_back(res);
+				helper(vertex);
+			}
 		}
+		reset();
+		return std::exchange(result, {});
+	}
 
+	// The strong component of [vertex] in the sub graph where all the vertices below [vertex] are dropped, i.e., the A_k of
+	// Johnson's algorithm. Only the vertices reachable from [vertex] are visited and their state is restored afterwards, so
+	// a single instance can answer many of these queries
+	std::vector<int> leastComponent(const int vertex)
+	{
+		leastVertex = vertex;
+		helper(vertex);
+		// the component of the root of the depth-first search is always the last one to be completed
+		auto component = std::move(result.back());
+		reset();
+		result.clear();
+		return component;
 	}
-public:
-	explicit StrongComponents(const Graph<T>& graph) : graph(graph), index(0)
+
+	// Split [vertices] into the strong components of the sub graph they induce, the edges leaving [vertices] are ignored
+	// Only the given vertices and their out edges are touched, so removing a vertex from a strong component costs as much as
+	// the component itself instead of the whole graph
+	std::vector<std::vector<int>> inducedStrongComponents(const std::span<const int> vertices)
+	{
+		inScope.resize(graph.vertexCount());
+		for (const int v : vertices)
+		{
+			inScope[v] = true;
+		}
+		scoped = true;
+		for (const int v : vertices)
+		{
+			if (indexMap[v] == -1)
+			{
+				helper(v);
+			}
+		}
+		scoped = false;
+		for (const int v : vertices)
+		{
+			inScope[v] = false;
+		}
+		reset();
+		return std::exchange(result, {});
+	}
+
+	// The strong components together with the DAG between them, so that later analyses can reuse them
+	StrongComponentCondensation condensation()
 	{
+		StrongComponentCondensation dag;
+		dag.components = denseStrongComponents();
+		dag.componentOf.assign(graph.vertexCount(), -1);
+		for (int component = 0; component < dag.componentCount(); component++)
+		{
+			for (const int vertex : dag.components[component])
+			{
+				dag.componentOf[vertex] = component;
+			}
+		}
+		// the last source component that added an edge to each target, which filters the duplicated edges in O(1)
+		std::vector<int> lastSource(dag.components.size(), -1);
+		dag.offsets.reserve(dag.components.size() + 1);
+		dag.offsets.push_back(0);
+		for (int component = 0; component < dag.componentCount(); component++)
+		{
+			for (const int vertex : dag.components[component])
+			{
+				for (const int successor : graph.successors(vertex))
+				{
+					const auto target = dag.componentOf[successor];
+					if (target != -1 && target != component && lastSource[target] != component)
+					{
+						lastSource[target] = component;
+						dag.targets.push_back(target);
+					}
+				}
+			}
+			dag.offsets.push_back(static_cast<int>(dag.targets.size()));
+		}
+		return dag;
 	}
 
 	std::vector<std::set<Node<T>>> strongComponents()
 	{
-		for (const Node<T>& vertex : graph.vertices())
+		std::vector<std::set<Node<T>>> components;
+		for (const auto& component : denseStrongComponents())
 		{
-			if (!indexMap.contains(vertex))
+			std::set<Node<T>> set;
+			for (const int vertex : component)
 			{
-				helper(vertex);
+				set.insert(graph.node(vertex));
 			}
+			components.push_back(set);
 		}
-		return result;
+		return components;
 	}
 };
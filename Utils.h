@@ -17,24 +17,13 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
-#include <numeric>
-#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "PathPool.h"
 
 namespace CircuitCalculator::Utils
 {
-	template <typename Itr, typename Fn = std::identity>
-	std::string Join(Itr begin, Itr end, const std::string& delimiter, Fn fn = {})
-	{
-		return std::accumulate(begin, end, std::string(), [&fn](const std::string& accumulator, const auto& str)
-			{
-				if (fn(str).empty())
-				{
-					return accumulator;
-				}
-				return accumulator.empty() ? fn(str) : accumulator + "+" + fn(str);
-			});
-	}
-
 	template <typename T>
 	bool PrefixDistinct(std::vector<std::vector<T>> vec, bool fromEnd = false)
 	{
@@ -51,4 +40,22 @@ namespace CircuitCalculator::Utils
 		}
 		return elements.size() == vec.size() - empties;
 	}
+
+	// Same as PrefixDistinct(vec, fromEnd) for the paths of [pool] referred to by [paths], only the end points are looked at,
+	// which the pool keeps for every handle
+	inline bool PrefixDistinct(const PathPool& pool, const std::vector<PathHandle>& paths, const bool fromEnd = false)
+	{
+		std::unordered_set<int> elements;
+		auto empties = 0;
+		for (const auto path : paths)
+		{
+			if (path.length == 0)
+			{
+				empties++;
+				continue;
+			}
+			elements.insert(fromEnd ? pool.back(path) : pool.front(path));
+		}
+		return elements.size() == paths.size() - empties;
+	}
 }
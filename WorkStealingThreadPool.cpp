@@ -0,0 +1,149 @@
+﻿#include "WorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+thread_local WorkStealingThreadPool* WorkStealingThreadPool::currentPool = nullptr;
+thread_local int WorkStealingThreadPool::currentWorker = -1;
+
+bool WorkStealingThreadPool::reserve()
+{
+	auto count = queued.load();
+	while (count > 0 && !queued.compare_exchange_weak(count, count - 1))
+	{
+	}
+	return count > 0;
+}
+
+bool WorkStealingThreadPool::take(const int worker, std::function<void()>& task)
+{
+	const auto size = static_cast<int>(queues.size());
+	for (auto i = 0; i < size; i++)
+	{
+		auto& queue = *queues[(worker + i) % size];
+		std::lock_guard lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			// the newest task of its own queue, or the oldest task of someone else's
+			if (i == 0)
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			else
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkStealingThreadPool::run(const int worker)
+{
+	currentPool = this;
+	currentWorker = worker;
+	while (true)
+	{
+		if (!reserve())
+		{
+			std::unique_lock lock(mutex);
+			// [sleeping] is raised before [queued] is checked, and submit raises [queued] before it checks [sleeping], so
+			// either this sees the new task or the submit sees this worker and notifies it under the lock
+			sleeping++;
+			available.wait(lock, [this] { return stopping || queued > 0; });
+			sleeping--;
+			if (stopping && queued == 0)
+			{
+				return;
+			}
+			continue;
+		}
+		// a task has been reserved for this worker, so this eventually finds one
+		std::function<void()> task;
+		while (!take(worker, task))
+		{
+			std::this_thread::yield();
+		}
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+			std::lock_guard lock(mutex);
+			if (exception == nullptr)
+			{
+				exception = std::current_exception();
+			}
+		}
+		if (--unfinished == 0)
+		{
+			// [wait] checks [unfinished] under the lock, so taking it here makes sure the waiter is either not checking yet
+			// or already waiting
+			std::lock_guard lock(mutex);
+			finished.notify_all();
+		}
+	}
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::size_t threadCount)
+{
+	const auto count = std::max<std::size_t>(threadCount, 1);
+	for (std::size_t i = 0; i < count; i++)
+	{
+		queues.push_back(std::make_unique<TaskQueue>());
+	}
+	for (std::size_t i = 0; i < count; i++)
+	{
+		threads.emplace_back(&WorkStealingThreadPool::run, this, static_cast<int>(i));
+	}
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	available.notify_all();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+int WorkStealingThreadPool::workerIndex() const
+{
+	return currentPool == this ? currentWorker : -1;
+}
+
+void WorkStealingThreadPool::submit(std::function<void()> task)
+{
+	const auto target = workerIndex() != -1 ? static_cast<std::size_t>(workerIndex()) : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+	unfinished++;
+	{
+		std::lock_guard lock(queues[target]->mutex);
+		queues[target]->tasks.push_back(std::move(task));
+	}
+	queued++;
+	if (sleeping > 0)
+	{
+		std::lock_guard lock(mutex);
+		available.notify_one();
+	}
+}
+
+void WorkStealingThreadPool::wait()
+{
+	assert(workerIndex() == -1 && "WorkStealingThreadPool::wait called from a task of the same pool");
+	std::unique_lock lock(mutex);
+	finished.wait(lock, [this] { return unfinished == 0; });
+	if (exception != nullptr)
+	{
+		std::rethrow_exception(std::exchange(exception, nullptr));
+	}
+}
@@ -0,0 +1,92 @@
+﻿// GPL v3 License
+// 
+// CircuitCalculator/CircuitCalculator
+// Copyright (c) 2022 CircuitCalculator/WorkStealingThreadPool.h
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed size thread pool where every worker owns a task queue
+// A worker takes tasks from the back of its own queue and, once that is empty, steals from the front of the others, so
+// that uneven tasks (e.g., the cycle searches from different start vertices) still keep every worker busy
+// Pushing and taking a task only lock the queue involved, the counters are atomics and the pool-wide mutex is only taken
+// to go to sleep and to wake the sleepers up
+class WorkStealingThreadPool
+{
+	struct TaskQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<TaskQueue>> queues;
+	std::vector<std::thread> threads;
+	// guards the sleep of the workers and of [wait], [stopping] and [exception]
+	std::mutex mutex;
+	// signaled when a task is submitted or the pool is stopping
+	std::condition_variable available;
+	// signaled when the last unfinished task finishes
+	std::condition_variable finished;
+	// the number of tasks in the queues that no worker has reserved yet
+	std::atomic<std::size_t> queued = 0;
+	std::atomic<std::size_t> unfinished = 0;
+	// the number of workers that are asleep or about to be, a submit only takes [mutex] to wake one up if there is one
+	std::atomic<std::size_t> sleeping = 0;
+	std::atomic<std::size_t> nextQueue = 0;
+	bool stopping = false;
+	std::exception_ptr exception;
+
+	static thread_local WorkStealingThreadPool* currentPool;
+	static thread_local int currentWorker;
+
+	// Reserve one of the queued tasks for the caller, false if there is none
+	bool reserve();
+
+	bool take(int worker, std::function<void()>& task);
+
+	void run(int worker);
+public:
+	explicit WorkStealingThreadPool(std::size_t threadCount = std::thread::hardware_concurrency());
+
+	WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+
+	WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+	~WorkStealingThreadPool();
+
+	std::size_t size() const
+	{
+		return threads.size();
+	}
+
+	// The index of the worker of this pool that runs the calling thread, -1 if the caller is not one of them
+	int workerIndex() const;
+
+	// Tasks submitted by a worker go to its own queue, the others are spread over all the queues
+	void submit(std::function<void()> task);
+
+	// Block until every submitted task has finished, rethrows the first exception thrown by a task
+	// It must not be called from a task of this pool, the task that waits would be one of those it waits for
+	void wait();
+};